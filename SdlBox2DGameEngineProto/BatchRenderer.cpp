@@ -0,0 +1,88 @@
+
+#include "BatchRenderer.h"
+
+#include <GL/freeglut.h>
+#include <GL/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+namespace bolt::game_engine
+{
+   // Purpose: Start a new frame (forget the polygons from the last frame, but keep the memory)
+   void BatchRenderer::begin()
+   {
+      local_points.clear();
+      point_offsets.clear();
+      point_offsets.push_back(0);   // The first polygon starts at the first point
+      x_positions.clear();
+      y_positions.clear();
+      angles.clear();
+      colors.clear();
+   }
+
+   // Purpose: Add a convex polygon given in body (local) coordinates, placed in the world at position and rotated by angle (radians)
+   void BatchRenderer::addPolygon(std::span<const buf::Vec2> points, b2Vec2 position, float angle, buf::Vec3 color)
+   {
+      assert(points.size() >= 3);
+      assert(!point_offsets.empty());   // begin() must be called first
+
+      local_points.insert(local_points.end(), points.begin(), points.end());
+      point_offsets.push_back(static_cast<std::uint32_t>(local_points.size()));
+      x_positions.push_back(position.x);
+      y_positions.push_back(position.y);
+      angles.push_back(angle);
+      colors.push_back(color);
+   }
+
+   // Purpose: Add a circle with its center given in body (local) coordinates, placed in the world at position and rotated by angle (radians)
+   void BatchRenderer::addCircle(b2Vec2 local_center, float radius, b2Vec2 position, float angle, buf::Vec3 color)
+   {
+      std::array<buf::Vec2, CircleSegments> points;
+      for (int segment = 0; segment < CircleSegments; ++segment)
+      {
+         const float segment_angle = segment * 2.0f * b2_pi / CircleSegments;
+         points[segment] = { local_center.x + radius * std::cos(segment_angle), local_center.y + radius * std::sin(segment_angle) };
+      }
+
+      addPolygon(points, position, angle, color);
+   }
+
+   // Purpose: Transform every polygon to world coordinates and draw them all with one draw call
+   void BatchRenderer::submit()
+   {
+      if (local_points.empty())
+         return;
+
+      world_points.resize(local_points.size());
+      buf::transformPointsBatch(local_points, point_offsets, x_positions, y_positions, angles, world_points);
+
+      // Split each (convex) polygon into a fan of triangles around its first point, so every polygon goes in one GL_TRIANGLES draw
+      triangle_indices.clear();
+      point_colors.resize(local_points.size());
+      for (std::size_t polygon = 0; polygon + 1 < point_offsets.size(); ++polygon)
+      {
+         std::fill(point_colors.begin() + point_offsets[polygon], point_colors.begin() + point_offsets[polygon + 1], colors[polygon]);
+
+         const std::uint32_t fan_center = point_offsets[polygon];
+         for (std::uint32_t point = fan_center + 2; point < point_offsets[polygon + 1]; ++point)
+         {
+            triangle_indices.push_back(fan_center);
+            triangle_indices.push_back(point - 1);
+            triangle_indices.push_back(point);
+         }
+      }
+
+      static_assert (sizeof(buf::Vec2) == sizeof(GLfloat) * 2);   // Vertices are passed to OpenGL as tightly packed float pairs
+      static_assert (sizeof(buf::Vec3) == sizeof(GLfloat) * 3);   // and colors as tightly packed float triples
+
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_COLOR_ARRAY);
+      glVertexPointer(2, GL_FLOAT, 0, world_points.data());
+      glColorPointer(3, GL_FLOAT, 0, point_colors.data());
+      glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(triangle_indices.size()), GL_UNSIGNED_INT, triangle_indices.data());
+      glDisableClientState(GL_COLOR_ARRAY);
+      glDisableClientState(GL_VERTEX_ARRAY);
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,48 @@
+#pragma once
+// Purpose: Collects the polygons of a frame (in body coordinates, with each body's transform) and submits the whole frame to 
+//          OpenGL with a single draw call, instead of a glBegin()/glEnd() per body.  The points are transformed to world
+//          coordinates on the CPU in one batch (see buf::transformPointsBatch()) into one (client side) vertex array.
+//    Note: Only uses OpenGL 1.1 vertex arrays, so it also runs on software OpenGL (e.g. Mesa llvmpipe) for headless benchmarking.
+//
+
+#include "bolt_buf.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   class BatchRenderer
+   {
+   public:
+      static constexpr int CircleSegments = 24;   // Circles are drawn as polygons with this many sides
+
+      // Start a new frame (forget the polygons from the last frame, but keep the memory)
+      void begin();
+      // Add a convex polygon given in body (local) coordinates, placed in the world at position and rotated by angle (radians)
+      void addPolygon(std::span<const buf::Vec2> local_points, b2Vec2 position, float angle, buf::Vec3 color);
+      // Add a circle with its center given in body (local) coordinates, placed in the world at position and rotated by angle (radians)
+      void addCircle(b2Vec2 local_center, float radius, b2Vec2 position, float angle, buf::Vec3 color);
+      // Transform every polygon to world coordinates and draw them all with one draw call
+      void submit();
+
+      // Number of polygon points added since begin()
+      std::size_t pointCount() const { return local_points.size(); };
+
+   private:
+      //// Polygons, one after another (as buf::transformPointsBatch() expects)
+      std::vector<buf::Vec2> local_points;         // Points of every polygon in body coordinates
+      std::vector<std::uint32_t> point_offsets;    // Polygon i is local_points[point_offsets[i]] to local_points[point_offsets[i + 1]]
+      std::vector<float> x_positions;              // World position and angle of each polygon
+      std::vector<float> y_positions;
+      std::vector<float> angles;
+      std::vector<buf::Vec3> colors;               // RGB color of each polygon
+
+      std::vector<buf::Vec2> world_points;         // local_points transformed to world coordinates (the vertex array)
+      std::vector<buf::Vec3> point_colors;         // Each point's polygon color (the color array)
+      std::vector<std::uint32_t> triangle_indices; // Each polygon as a fan of triangles (indices into world_points)
+   };
+} // End namespace bolt::game_engine
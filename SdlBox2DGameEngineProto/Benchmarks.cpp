@@ -0,0 +1,861 @@
+
+#include "Benchmarks.h"
+#include "bolt_buf.h"
+#include "PrefabRegistry.h"
+#include "Simulation.h"
+#include "SimulationHost.h"
+#include "WorldSnapshot.h"
+
+#include <Box2D/Box2D.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
+
+using namespace std::string_literals;
+
+namespace bolt::game_engine
+{
+   using namespace buf;
+
+   namespace
+   {
+      // Purpose: Return the average time (in nanoseconds) of one call to func, calling it repeatedly for at least min_seconds
+      template <typename Func>
+      double averageNanoseconds(Func&& func, double min_seconds = 0.25)
+      {
+         using Clock = std::chrono::steady_clock;
+
+         func();   // Warm up (caches, page faults, lazy allocation)
+
+         std::int64_t calls = 0;
+         const auto start = Clock::now();
+         std::chrono::duration<double> elapsed{};
+         do
+         {
+            func();
+            ++calls;
+            elapsed = Clock::now() - start;
+         } while (elapsed.count() < min_seconds);
+
+         return elapsed.count() * 1.0e9 / calls;
+      }
+
+      // Purpose: Create a dynamic triangle body the way Simulation::addPolygon() does, building the definitions and the shape 
+      //    (whose convex hull and mass are computed by Box2D) from scratch
+      b2Body* createTriangleFromScratch(b2World& world, std::span<const Vec2> triangle, b2Vec2 position)
+      {
+         b2BodyDef bodydef;
+         bodydef.position = position;
+         bodydef.type = b2_dynamicBody;
+         b2Body* body = world.CreateBody(&bodydef);
+
+         b2PolygonShape shape;
+         shape.Set(cvert(triangle.data()), static_cast<int32>(triangle.size()));
+
+         b2FixtureDef fixture_def;
+         fixture_def.shape = &shape;
+         fixture_def.density = 1.0;
+         body->CreateFixture(&fixture_def);
+
+         return body;
+      }
+
+      // Purpose: Return true if Box2D's allocations are counted (it was built with the engine's settings, see b2_user_settings.h)
+      bool box2DAllocationsCounted()
+      {
+         const AllocationCounts allocations_before = allocationCounts();
+         {
+            b2World world(b2Vec2(0.0f, -9.8f));   // Allocates its broadphase tree (and the body its first block) with b2Alloc()
+            b2BodyDef bodydef;
+            world.CreateBody(&bodydef);
+         }
+         return (allocationCounts() - allocations_before).malloc_allocations > 0;
+      }
+
+      // Purpose: Add a static box (like the engine's platform) to the world
+      void addStaticBox(b2World& world, b2Vec2 center, float width, float height)
+      {
+         b2BodyDef bodydef;
+         bodydef.position = center;
+         b2Body* body = world.CreateBody(&bodydef);
+
+         b2PolygonShape shape;
+         shape.SetAsBox(width / 2, height / 2);
+         body->CreateFixture(&shape, 0.0f /*density*/);
+      }
+
+      // Purpose: Return the number of contacts in the world whose fixtures are touching (not just overlapping bounding boxes)
+      std::int32_t touchingContactCount(b2World& world)
+      {
+         std::int32_t touching = 0;
+         for (b2Contact* contact = world.GetContactList(); contact != nullptr; contact = contact->GetNext())
+         {
+            if (contact->IsTouching())
+               ++touching;
+         }
+         return touching;
+      }
+
+      // Purpose: Return the number of awake bodies in the world
+      std::int32_t awakeBodyCount(b2World& world)
+      {
+         std::int32_t awake = 0;
+         for (b2Body* body = world.GetBodyList(); body != nullptr; body = body->GetNext())
+         {
+            if (body->IsAwake())
+               ++awake;
+         }
+         return awake;
+      }
+   }
+
+   // Purpose: Run the named benchmark, or every benchmark if the name is "all"
+   Result<void> Benchmarks::run(std::string_view name)
+   {
+      const bool all = (name == "all");
+      bool found = all;
+
+      if (all || name == "transform")
+      {
+         if (auto result = benchTransformPoints(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "centroid")
+      {
+         if (auto result = benchCentroids(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "spawn")
+      {
+         if (auto result = benchSpawnStorm(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "step")
+      {
+         if (auto result = benchStepThroughput(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "worlds")
+      {
+         if (auto result = benchParallelWorlds(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "snapshot")
+      {
+         if (auto result = benchSnapshot(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "hash")
+      {
+         if (auto result = benchStateHash(); !result)
+            return result;
+         found = true;
+      }
+
+      if (all || name == "profile")
+      {
+         if (auto result = benchProfiler(); !result)
+            return result;
+         found = true;
+      }
+
+      if (!found)
+         return buf::unexpected(std::format("Unknown benchmark: {} (try: transform, centroid, spawn, step, worlds, snapshot, hash, profile, all)", name));
+
+      return Result<void>{};
+   }
+
+   // Purpose: Compare transforming the points of 1k, 10k and 100k triangles to world coordinates
+   //    The SIMD sine and cosine are accurate to about 1e-6, so the SIMD points must be within TransformTolerance of the scalar ones.
+   Result<void> Benchmarks::benchTransformPoints()
+   {
+      constexpr float TransformTolerance = 1.0e-4f;   // Meters (a tenth of a millimeter)
+
+      std::cout << "Transform points (triangles) to world coordinates, ns per body" << std::endl;
+      std::cout << std::format("{:>10} {:>10} {:>10} {:>10} {:>10} {:>12}", "bodies", "glm", "scalar", "simd", "speedup", "max_error") << std::endl;
+
+      const std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+
+      for (const std::size_t body_count : { 1'000, 10'000, 100'000 })
+      {
+         // Bodies scattered over the world, at any angle (including ones that have spun many times)
+         std::mt19937 random{ 42 };
+         std::uniform_real_distribution<float> random_position{ 0.0f, 12.8f };
+         std::uniform_real_distribution<float> random_angle{ -100.0f, 100.0f };
+
+         std::vector<float> x(body_count), y(body_count), angles(body_count);
+         std::vector<std::uint32_t> point_offsets(body_count + 1);
+         std::vector<Vec2> local_points;
+         local_points.reserve(body_count * triangle.size());
+
+         for (std::size_t body = 0; body < body_count; ++body)
+         {
+            x[body] = random_position(random);
+            y[body] = random_position(random);
+            angles[body] = random_angle(random);
+            point_offsets[body] = static_cast<std::uint32_t>(local_points.size());
+            local_points.insert(local_points.end(), triangle.begin(), triangle.end());
+         }
+         point_offsets[body_count] = static_cast<std::uint32_t>(local_points.size());
+
+         std::vector<Vec2> glm_points(local_points.size()), scalar_points(local_points.size()), simd_points(local_points.size());
+
+         // glm: build a rotation matrix per body (the way the OpenGL matrix stack did it one body at a time)
+         const double glm_ns = averageNanoseconds([&]() 
+         {
+            for (std::size_t body = 0; body < body_count; ++body)
+            {
+               const float cos_angle = std::cos(angles[body]);
+               const float sin_angle = std::sin(angles[body]);
+               const Mat2 rotation{ cos_angle, sin_angle, -sin_angle, cos_angle };
+               const Vec2 translation{ x[body], y[body] };
+
+               for (std::uint32_t point = point_offsets[body]; point < point_offsets[body + 1]; ++point)
+                  glm_points[point] = rotation * local_points[point] + translation;
+            }
+         });
+         const double scalar_ns = averageNanoseconds([&]() { transformPointsBatchScalar(local_points, point_offsets, x, y, angles, scalar_points); });
+         const double simd_ns = averageNanoseconds([&]() { transformPointsBatch(local_points, point_offsets, x, y, angles, simd_points); });
+
+         // Check the SIMD results against the scalar ones
+         float max_error = 0.0f;
+         for (std::size_t point = 0; point < local_points.size(); ++point)
+         {
+            max_error = std::max(max_error, std::abs(simd_points[point].x - scalar_points[point].x));
+            max_error = std::max(max_error, std::abs(simd_points[point].y - scalar_points[point].y));
+         }
+
+         std::cout << std::format("{:>10} {:>10.2f} {:>10.2f} {:>10.2f} {:>9.2f}x {:>12.3g}", body_count, 
+            glm_ns / body_count, scalar_ns / body_count, simd_ns / body_count, scalar_ns / simd_ns, max_error) << std::endl;
+
+         if (max_error > TransformTolerance)
+            return buf::unexpected(std::format("SIMD transform of {} bodies is {} from the scalar transform (tolerance {}).", body_count, max_error, TransformTolerance));
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Check buf::calculateCentroid() on known polygons, then measure the throughput of buf::calculateCentroidsBatch()
+   Result<void> Benchmarks::benchCentroids()
+   {
+      //// Correctness checks
+      struct CentroidCheck
+      {
+         const char* name;
+         std::vector<Vec2> points;
+         Vec2 expected;
+      };
+      const std::vector<CentroidCheck> checks
+      {
+         { "counter-clockwise triangle", { {0, 0}, {3, 0}, {0, 3} }, {1, 1} },
+         { "clockwise triangle",         { {0, 0}, {0, 3}, {3, 0} }, {1, 1} },
+         { "offset square",              { {10, 10}, {12, 10}, {12, 12}, {10, 12} }, {11, 11} },
+         { "far from origin",            { {1000, 1000}, {1003, 1000}, {1000, 1003} }, {1001, 1001} },
+         { "bad (off center) triangle",  { {-0.1333f + 0.5f, -0.0667f}, {0.0667f + 0.5f, -0.0667f}, {0.0667f + 0.5f, 0.1333f} }, {0.5f, 0.0f} },
+         { "degenerate: collinear",      { {0, 0}, {1, 1}, {2, 2} }, {1, 1} },
+         { "degenerate: repeated point", { {2, 3}, {2, 3}, {2, 3} }, {2, 3} },
+         { "degenerate: single point",   { {4, 5} }, {4, 5} },
+      };
+
+      constexpr float tolerance = 1.0e-3f;
+      for (const auto& check : checks)
+      {
+         const Vec2 centroid = calculateCentroid(check.points);
+         if (std::abs(centroid.x - check.expected.x) > tolerance || std::abs(centroid.y - check.expected.y) > tolerance)
+            return buf::unexpected(std::format("Centroid check failed: {}: got [{}, {}] expected [{}, {}]", check.name, centroid.x, centroid.y, check.expected.x, check.expected.y));
+      }
+
+      // orientToCentroid() moves the points so their centroid is the origin, and returns where the centroid was
+      std::vector<Vec2> oriented{ checks[4].points };
+      const Vec2 offset = orientToCentroid(oriented);
+      const Vec2 oriented_centroid = calculateCentroid(oriented);
+      if (std::abs(offset.x - checks[4].expected.x) > tolerance || std::abs(oriented_centroid.x) > tolerance || std::abs(oriented_centroid.y) > tolerance)
+         return buf::unexpected("Centroid check failed: orientToCentroid()"s);
+
+      std::cout << std::format("Centroid checks passed ({})", checks.size() + 1) << std::endl;
+
+      //// Throughput: polygons of 3 to 8 points
+      std::cout << "Centroids of polygons (3 to 8 points), ns per polygon" << std::endl;
+      std::cout << std::format("{:>10} {:>10}", "polygons", "batch") << std::endl;
+
+      for (const std::size_t polygon_count : { 1'000, 100'000 })
+      {
+         std::mt19937 random{ 7 };
+         std::uniform_real_distribution<float> random_position{ -1.0f, 1.0f };
+
+         std::vector<Vec2> points;
+         std::vector<std::uint32_t> point_offsets{ 0 };
+         for (std::size_t polygon = 0; polygon < polygon_count; ++polygon)
+         {
+            for (std::size_t point = 0; point < 3 + polygon % 6; ++point)
+               points.push_back({ random_position(random), random_position(random) });
+            point_offsets.push_back(static_cast<std::uint32_t>(points.size()));
+         }
+
+         std::vector<Vec2> centroids(polygon_count);
+         const double batch_ns = averageNanoseconds([&]() { calculateCentroidsBatch(points, point_offsets, centroids); });
+
+         std::cout << std::format("{:>10} {:>10.2f}", polygon_count, batch_ns / polygon_count) << std::endl;
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Create and destroy 1k to 1M triangles in a bare Box2D world, in bursts, as a steady trickle, and as churn with a 
+   //    stable population.  Each body is built from scratch (like Simulation::addPolygon()) and from a prefab (like Engine::spawnMany()).
+   //    Note: The world is never stepped, so only creating and destroying bodies (and their broadphase proxies) is measured.
+   Result<void> Benchmarks::benchSpawnStorm()
+   {
+      using Clock = std::chrono::steady_clock;
+      using Seconds = std::chrono::duration<double>;
+
+      constexpr std::size_t trickle_population = 256;   // Bodies alive at once in the trickle pattern
+      constexpr float world_size = 1000.0f;             // Bodies are placed at random in a square this many meters wide
+
+      std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+      orientToCentroid(triangle);
+
+      PrefabRegistry prefabs;
+      auto prefab_result = prefabs.addPolygon(triangle, b2_dynamicBody, 1.0f /*density*/, BodyMetadata{});
+      if (!prefab_result)
+         return buf::unexpected(prefab_result.error());
+      const PrefabHandle triangle_prefab = *prefab_result;
+
+      std::cout << "Spawn storm: create and destroy triangles in a bare Box2D world" << std::endl;
+      std::cout << "   burst-create/burst-destroy: op = create (then destroy) one of N bodies, all at once" << std::endl;
+      std::cout << "   trickle: op = create one body and destroy the oldest (" << trickle_population << " alive)" << std::endl;
+      std::cout << "   churn:   op = destroy a random body and create one (N alive)" << std::endl;
+      std::cout << "   allocs/op: calls to operator new and Box2D's b2Alloc()" << std::endl;
+      std::cout << "   rss_growth_mb: change in the process's resident memory over the run (negative if memory was given back)" << std::endl;
+      if (!AllocationCountingEnabled)
+         std::cout << "   allocs/op: not counted (built without BOLT_COUNT_ALLOCATIONS, e.g. not the Benchmark configuration)" << std::endl;
+      else if (!box2DAllocationsCounted())
+         std::cout << "   allocs/op: only operator new counted (built without B2_USER_SETTINGS, see b2_user_settings.h)" << std::endl;
+      std::cout << std::format("{:>14} {:>8} {:>10} {:>10} {:>10} {:>14}", "pattern", "path", "bodies", "ns/op", "allocs/op", "rss_growth_mb") << std::endl;
+
+      for (const std::size_t body_count : { 1'000, 10'000, 100'000, 1'000'000 })
+      {
+         std::mt19937 random{ 11 };
+         std::uniform_real_distribution<float> random_position{ 0.0f, world_size };
+         std::vector<b2Vec2> positions(body_count);
+         for (b2Vec2& position : positions)
+            position.Set(random_position(random), random_position(random));
+
+         std::uniform_int_distribution<std::size_t> random_body{ 0, body_count - 1 };
+         std::vector<std::size_t> churn_indices(body_count);
+         for (std::size_t& index : churn_indices)
+            index = random_body(random);
+
+         for (const bool from_prefab : { false, true })
+         {
+            const char* path = from_prefab ? "prefab" : "scratch";
+            auto create_one = [&](b2World& world, b2Vec2 position)
+            {
+               if (!from_prefab)
+                  return createTriangleFromScratch(world, triangle, position);
+
+               b2Body* created = nullptr;
+               prefabs.createBodies(world, triangle_prefab, std::span<const b2Vec2>(&position, 1), [&created](b2Body* body) { created = body; });
+               return created;
+            };
+
+            // Time func() over op_count operations, and print a row
+            auto measure = [&](const char* pattern, std::size_t op_count, auto&& func)
+            {
+               const std::size_t resident_bytes_before = processResidentBytes();
+               const AllocationCounts allocations_before = allocationCounts();
+               const auto start = Clock::now();
+               func();
+               const Seconds elapsed = Clock::now() - start;
+               const AllocationCounts allocations = allocationCounts() - allocations_before;
+               const double rss_growth_bytes = static_cast<double>(processResidentBytes()) - static_cast<double>(resident_bytes_before);
+
+               std::cout << std::format("{:>14} {:>8} {:>10} {:>10.1f} {:>10.2f} {:>14.1f}", pattern, path, body_count, elapsed.count() * 1.0e9 / op_count, 
+                  static_cast<double>(allocations.allocations) / op_count, rss_growth_bytes / (1024.0 * 1024.0)) << std::endl;
+            };
+
+            std::vector<b2Body*> bodies;
+            bodies.reserve(body_count);
+
+            //// Burst: create N bodies at once (a prefab spawns them all with one call), then destroy them all
+            {
+               auto world = std::make_unique<b2World>(b2Vec2(0.0f, -9.8f));
+
+               measure("burst-create", body_count, [&]()
+               {
+                  if (from_prefab)
+                     prefabs.createBodies(*world, triangle_prefab, positions, [&bodies](b2Body* body) { bodies.push_back(body); });
+                  else
+                  {
+                     for (const b2Vec2& position : positions)
+                        bodies.push_back(createTriangleFromScratch(*world, triangle, position));
+                  }
+               });
+               measure("burst-destroy", body_count, [&]()
+               {
+                  for (b2Body* body : bodies)
+                     world->DestroyBody(body);
+               });
+               bodies.clear();
+            }
+
+            //// Trickle: a small population, replaced one body at a time (oldest first)
+            {
+               auto world = std::make_unique<b2World>(b2Vec2(0.0f, -9.8f));
+
+               measure("trickle", body_count, [&]()
+               {
+                  std::size_t oldest = 0;
+                  for (const b2Vec2& position : positions)
+                  {
+                     if (bodies.size() < trickle_population)
+                        bodies.push_back(create_one(*world, position));
+                     else
+                     {
+                        world->DestroyBody(bodies[oldest]);
+                        bodies[oldest] = create_one(*world, position);
+                        oldest = (oldest + 1) % trickle_population;
+                     }
+                  }
+               });
+               bodies.clear();
+            }
+
+            //// Churn: N bodies alive, each operation replaces one chosen at random
+            {
+               auto world = std::make_unique<b2World>(b2Vec2(0.0f, -9.8f));
+               prefabs.createBodies(*world, triangle_prefab, positions, [&bodies](b2Body* body) { bodies.push_back(body); });
+
+               measure("churn", body_count, [&]()
+               {
+                  for (std::size_t op = 0; op < body_count; ++op)
+                  {
+                     b2Body*& body = bodies[churn_indices[op]];
+                     world->DestroyBody(body);
+                     body = create_one(*world, positions[op]);
+                  }
+               });
+               bodies.clear();
+            }
+         }
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Time b2World::Step() on scenes of 250 to 4000 bodies, at the engine's solver iterations and then a sweep of others
+   //    Note: Each run builds its scene in a new world, lets it settle for warm_up_steps, then times measured_steps one at a time.
+   //          Contacts and awake bodies are counted between the timed steps.
+   Result<void> Benchmarks::benchStepThroughput()
+   {
+      using Clock = std::chrono::steady_clock;
+      using Seconds = std::chrono::duration<double>;
+
+      constexpr float time_step = 1.0f / 60.0f;
+      constexpr int warm_up_steps = 60;
+      constexpr int measured_steps = 240;
+
+      std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+      orientToCentroid(triangle);
+      const std::vector<Vec2> box{ {-0.1f, -0.1f}, {0.1f, -0.1f}, {0.1f, 0.1f}, {-0.1f, 0.1f} };
+
+      PrefabRegistry prefabs;
+      auto triangle_result = prefabs.addPolygon(triangle, b2_dynamicBody, 1.0f /*density*/, BodyMetadata{});
+      if (!triangle_result)
+         return buf::unexpected(triangle_result.error());
+      auto box_result = prefabs.addPolygon(box, b2_dynamicBody, 1.0f /*density*/, BodyMetadata{});
+      if (!box_result)
+         return buf::unexpected(box_result.error());
+
+      // Add the scene's bodies to an empty world
+      enum class Scene { Platform, Pyramid, Sparse };
+      auto build_scene = [&](b2World& world, Scene scene, std::size_t body_count)
+      {
+         std::vector<b2Vec2> positions;
+         positions.reserve(body_count);
+
+         switch (scene)
+         {
+         case Scene::Platform:   // Like initBox2DWorld(): triangles falling (in rows) onto the platform, and piling up
+            addStaticBox(world, b2Vec2(6.4f, 0.8f), 10.0f, 0.4f);
+            for (std::size_t index = 0; index < body_count; ++index)
+               positions.emplace_back(1.6f + 0.24f * static_cast<float>(index % 40), 2.0f + 0.3f * static_cast<float>(index / 40));
+            prefabs.createBodies(world, *triangle_result, positions, [](b2Body*) {});
+            break;
+
+         case Scene::Pyramid:    // Boxes stacked in a pyramid on wide ground (contacts that must be solved every step)
+         {
+            std::size_t base = 1;
+            while (base * (base + 1) / 2 < body_count)
+               ++base;
+
+            addStaticBox(world, b2Vec2(0.0f, -0.5f), 0.4f * static_cast<float>(base), 1.0f);
+            for (std::size_t row = 0; row < base && positions.size() < body_count; ++row)
+            {
+               for (std::size_t column = 0; column < base - row && positions.size() < body_count; ++column)
+                  positions.emplace_back(0.2f * static_cast<float>(column) - 0.1f * static_cast<float>(base - row - 1), 0.1f + 0.2f * static_cast<float>(row));
+            }
+            prefabs.createBodies(world, *box_result, positions, [](b2Body*) {});
+            break;
+         }
+
+         case Scene::Sparse:     // Triangles scattered far apart, falling with nothing to hit (no contacts)
+         {
+            std::mt19937 random{ 3 };
+            std::uniform_real_distribution<float> random_position{ 0.0f, 1000.0f };
+            for (std::size_t index = 0; index < body_count; ++index)
+               positions.emplace_back(random_position(random), random_position(random));
+            prefabs.createBodies(world, *triangle_result, positions, [](b2Body*) {});
+            break;
+         }
+         }
+      };
+
+      // The engine's iterations first, then the sweep
+      std::vector<std::pair<std::int32_t, std::int32_t>> iterations{ { Simulation::VelocityIterations, Simulation::PositionIterations } };
+      for (const std::int32_t velocity_iterations : { 2, 5, 8 })
+      {
+         for (const std::int32_t position_iterations : { 1, 3, 5 })
+         {
+            if (velocity_iterations != Simulation::VelocityIterations || position_iterations != Simulation::PositionIterations)
+               iterations.emplace_back(velocity_iterations, position_iterations);
+         }
+      }
+
+      std::cerr << "Step throughput (CSV)" << std::endl;   // The title goes to stderr, so stdout is valid CSV (with --bench step)
+      std::cout << "scene,bodies,velocity_iterations,position_iterations,ms_per_step,contacts_per_step,awake_bodies" << std::endl;
+
+      const std::pair<Scene, const char*> scenes[]{ { Scene::Platform, "platform" }, { Scene::Pyramid, "pyramid" }, { Scene::Sparse, "sparse" } };
+      for (const auto& [scene, scene_name] : scenes)
+      {
+         for (const std::size_t body_count : { 250, 1'000, 4'000 })
+         {
+            for (const auto& [velocity_iterations, position_iterations] : iterations)
+            {
+               auto world = std::make_unique<b2World>(b2Vec2(0.0f, -9.8f));
+               build_scene(*world, scene, body_count);
+
+               for (int step = 0; step < warm_up_steps; ++step)
+                  world->Step(time_step, velocity_iterations, position_iterations);
+
+               Seconds step_time{};
+               std::int64_t contacts = 0;
+               std::int64_t awake_bodies = 0;
+               for (int step = 0; step < measured_steps; ++step)
+               {
+                  const auto start = Clock::now();
+                  world->Step(time_step, velocity_iterations, position_iterations);
+                  step_time += Clock::now() - start;
+
+                  contacts += touchingContactCount(*world);
+                  awake_bodies += awakeBodyCount(*world);
+               }
+
+               std::cout << std::format("{},{},{},{},{:.4f},{:.1f},{:.1f}", scene_name, body_count, velocity_iterations, position_iterations,
+                  step_time.count() * 1000.0 / measured_steps, static_cast<double>(contacts) / measured_steps, static_cast<double>(awake_bodies) / measured_steps) << std::endl;
+            }
+         }
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Step many independent worlds (each a platform with triangles piling on it) with a SimulationHost on 1 thread, 
+   //    then on more threads up to the number of cores.  Prints CSV: world steps per second, and the speedup and efficiency 
+   //    (speedup per thread) compared to one thread.
+   //    Note: Every world uses fixed solver iterations, so each run does the same work however long its steps take.
+   Result<void> Benchmarks::benchParallelWorlds()
+   {
+      using Clock = std::chrono::steady_clock;
+      using Seconds = std::chrono::duration<double>;
+
+      constexpr std::size_t bodies_per_world = 400;
+      constexpr std::int32_t warm_up_steps = 60;
+      constexpr std::int32_t measured_steps = 240;
+
+      const std::size_t core_count = std::max(1u, std::thread::hardware_concurrency());
+      const std::size_t world_count = std::max<std::size_t>(16, 2 * core_count);   // Enough worlds to keep every thread busy
+
+      std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+      orientToCentroid(triangle);
+
+      PrefabRegistry prefabs;
+      auto triangle_result = prefabs.addPolygon(triangle, b2_dynamicBody, 1.0f /*density*/, { .kind = BodyKind::Dynamic, .render_style = RenderStyle::Block });
+      if (!triangle_result)
+         return buf::unexpected(triangle_result.error());
+
+      std::vector<b2Vec2> positions;
+      for (std::size_t index = 0; index < bodies_per_world; ++index)
+         positions.emplace_back(1.6f + 0.24f * static_cast<float>(index % 40), 2.0f + 0.3f * static_cast<float>(index / 40));
+
+      // 1, 2, 4, ... threads, and finally every core
+      std::vector<std::size_t> thread_counts;
+      for (std::size_t thread_count = 1; thread_count < core_count; thread_count *= 2)
+         thread_counts.push_back(thread_count);
+      thread_counts.push_back(core_count);
+
+      std::cerr << std::format("Parallel worlds (CSV): {} cores", core_count) << std::endl;   // The title goes to stderr, so stdout is valid CSV (with --bench worlds)
+      std::cout << "worlds,bodies_per_world,threads,world_steps_per_sec,speedup,efficiency" << std::endl;
+
+      double one_thread_rate = 0.0;
+      for (const std::size_t thread_count : thread_counts)
+      {
+         SimulationHost host(thread_count);
+         for (std::size_t world_index = 0; world_index < world_count; ++world_index)
+         {
+            Simulation& simulation = host.addSimulation();
+            simulation.setAdaptiveIterations(false);
+            simulation.createWorld(b2Vec2(0.0f, -9.8f));
+            simulation.addRect(6.4f, 0.8f, 10.0f, 0.4f, false /*not dynamic, so static*/);
+            simulation.spawnMany(prefabs, *triangle_result, positions);
+         }
+
+         host.stepAll(warm_up_steps);
+
+         const auto start = Clock::now();
+         host.stepAll(measured_steps);
+         const Seconds elapsed = Clock::now() - start;
+
+         const double rate = static_cast<double>(world_count * measured_steps) / elapsed.count();
+         if (thread_count == 1)
+            one_thread_rate = rate;
+
+         const double speedup = rate / one_thread_rate;
+         std::cout << std::format("{},{},{},{:.1f},{:.2f},{:.2f}", world_count, bodies_per_world, thread_count, rate, speedup, speedup / thread_count) << std::endl;
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Capture and restore WorldSnapshots of 1k to 16k triangles piled on the platform, and compare restoring with 
+   //    building the scene again from scratch.  Reports the snapshot's size, the times, and the heap allocations of each.
+   //    Returns an error if a restored world differs from the captured one.
+   Result<void> Benchmarks::benchSnapshot()
+   {
+      constexpr std::int32_t settle_steps = 120;   // Let the triangles fall and pile up (so some are asleep) before capturing
+
+      std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+      orientToCentroid(triangle);
+
+      PrefabRegistry prefabs;
+      auto triangle_result = prefabs.addPolygon(triangle, b2_dynamicBody, 1.0f /*density*/, { .kind = BodyKind::Dynamic, .render_style = RenderStyle::Block });
+      if (!triangle_result)
+         return buf::unexpected(triangle_result.error());
+
+      std::cout << "World snapshots: capture and restore, compared with building the scene from scratch" << std::endl;
+      if (!AllocationCountingEnabled)
+         std::cout << "   allocs: not counted (built without BOLT_COUNT_ALLOCATIONS, e.g. not the Benchmark configuration)" << std::endl;
+      std::cout << std::format("{:>8} {:>12} {:>10} {:>12} {:>12} {:>12} {:>14} {:>14}", "bodies", "bytes", "bytes/body", "capture_us", "restore_us", 
+         "rebuild_us", "restore_allocs", "rebuild_allocs") << std::endl;
+
+      for (const std::size_t body_count : { 1'000, 4'000, 16'000 })
+      {
+         std::vector<b2Vec2> positions;
+         for (std::size_t index = 0; index < body_count; ++index)
+            positions.emplace_back(1.6f + 0.24f * static_cast<float>(index % 40), 2.0f + 0.3f * static_cast<float>(index / 40));
+
+         // Build the scene from scratch, the way the engine does
+         auto build_scene = [&](Simulation& simulation)
+         {
+            simulation.createWorld(b2Vec2(0.0f, -9.8f));
+            simulation.addRect(6.4f, 0.8f, 10.0f, 0.4f, false /*not dynamic, so static*/);
+            simulation.spawnMany(prefabs, *triangle_result, positions);
+         };
+
+         Simulation simulation;
+         simulation.setAdaptiveIterations(false);
+         build_scene(simulation);
+         for (std::int32_t step = 0; step < settle_steps; ++step)
+            simulation.step();
+
+         WorldSnapshot snapshot;
+         if (auto result = snapshot.capture(simulation); !result)
+            return result;
+         // A failure while timing is kept (the first one) and returned once the timing is done, rather than reported as a time
+         Result<void> timed_result;
+         auto keepFailure = [&timed_result](Result<void> result) 
+         {
+            if (!result && timed_result)
+               timed_result = std::move(result);
+         };
+
+         const double capture_ns = averageNanoseconds([&]() { keepFailure(snapshot.capture(simulation)); });
+         if (!timed_result)
+            return timed_result;
+
+         // Restore into a world that has moved on, and check it is back where it was captured
+         for (std::int32_t step = 0; step < 10; ++step)
+            simulation.step();
+         if (auto result = snapshot.restore(simulation); !result)
+            return result;
+
+         WorldSnapshot check_snapshot;
+         if (auto result = check_snapshot.capture(simulation); !result)
+            return result;
+         if (auto result = check_snapshot.compare(snapshot, 1.0e-5f); !result)
+            return buf::unexpected(std::format("Restored world of {} bodies does not match the captured world: {}", body_count, result.error()));
+
+         const double restore_ns = averageNanoseconds([&]() { keepFailure(snapshot.restore(simulation)); });
+         if (!timed_result)
+            return timed_result;
+         const AllocationCounts restore_allocations_before = allocationCounts();
+         const Result<void> restore_result = snapshot.restore(simulation);
+         const AllocationCounts restore_allocations = allocationCounts() - restore_allocations_before;
+         if (!restore_result)
+            return restore_result;
+
+         Simulation rebuilt_simulation;
+         const double rebuild_ns = averageNanoseconds([&]() { build_scene(rebuilt_simulation); });
+         const AllocationCounts rebuild_allocations_before = allocationCounts();
+         build_scene(rebuilt_simulation);
+         const AllocationCounts rebuild_allocations = allocationCounts() - rebuild_allocations_before;
+
+         std::cout << std::format("{:>8} {:>12} {:>10.1f} {:>12.1f} {:>12.1f} {:>12.1f} {:>14} {:>14}", body_count, snapshot.size(), 
+            static_cast<double>(snapshot.size()) / simulation.getBodyCounts().live, capture_ns / 1000.0, restore_ns / 1000.0, rebuild_ns / 1000.0, 
+            restore_allocations.allocations, rebuild_allocations.allocations) << std::endl;
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Step two identical worlds of 1k to 16k triangles side by side, checking their state hashes match after every
+   //    step, then compare the time to hash the state with the time of a step.  Returns an error if the hashes differ, or if
+   //    the SIMD hash differs from the scalar one.
+   Result<void> Benchmarks::benchStateHash()
+   {
+      constexpr std::int32_t check_steps = 120;   // Steps compared (the triangles fall, land and pile up)
+
+      std::vector<Vec2> triangle{ {-0.1333f, -0.0667f}, {0.0667f, -0.0667f}, {0.0667f, 0.1333f} };
+      orientToCentroid(triangle);
+
+      PrefabRegistry prefabs;
+      auto triangle_result = prefabs.addPolygon(triangle, b2_dynamicBody, 1.0f /*density*/, { .kind = BodyKind::Dynamic, .render_style = RenderStyle::Block });
+      if (!triangle_result)
+         return buf::unexpected(triangle_result.error());
+
+      std::cout << "State hash: two identical worlds stepped side by side, and the cost of hashing after every step" << std::endl;
+      std::cout << std::format("{:>8} {:>12} {:>12} {:>12} {:>12} {:>12}", "bodies", "steps_same", "hash_us", "ns/body", "step_us", "hash/step") << std::endl;
+
+      for (const std::size_t body_count : { 1'000, 4'000, 16'000 })
+      {
+         std::vector<b2Vec2> positions;
+         for (std::size_t index = 0; index < body_count; ++index)
+            positions.emplace_back(1.6f + 0.24f * static_cast<float>(index % 40), 2.0f + 0.3f * static_cast<float>(index / 40));
+
+         Simulation simulations[2];
+         for (Simulation& simulation : simulations)
+         {
+            simulation.setAdaptiveIterations(false);   // Fixed iterations, as in deterministic mode
+            simulation.createWorld(b2Vec2(0.0f, -9.8f));
+            simulation.addRect(6.4f, 0.8f, 10.0f, 0.4f, false /*not dynamic, so static*/);
+            simulation.spawnMany(prefabs, *triangle_result, positions);
+         }
+
+         for (std::int32_t step = 0; step < check_steps; ++step)
+         {
+            simulations[0].step();
+            simulations[1].step();
+            const std::uint64_t hash_0 = simulations[0].getTransformMirror().stateHash();
+            const std::uint64_t hash_1 = simulations[1].getTransformMirror().stateHash();
+            if (hash_0 != hash_1)
+               return buf::unexpected(std::format("Identical worlds of {} bodies differ at step {} (state hash {:016x}, not {:016x}).", body_count, step + 1, hash_1, hash_0));
+         }
+
+         const TransformMirror& transform_mirror = simulations[0].getTransformMirror();
+         if (hashFloats(transform_mirror.x()) != hashFloatsScalar(transform_mirror.x()))
+            return buf::unexpected("The SIMD hash differs from the scalar hash."s);
+
+         const double hash_ns = averageNanoseconds([&]() { transform_mirror.stateHash(); });
+         const double step_ns = averageNanoseconds([&]() { simulations[0].step(); });
+
+         std::cout << std::format("{:>8} {:>12} {:>12.2f} {:>12.3f} {:>12.1f} {:>11.3f}%", body_count, check_steps, hash_ns / 1000.0, 
+            hash_ns / body_count, step_ns / 1000.0, 100.0 * hash_ns / step_ns) << std::endl;
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Measure the cost of a timed scope against reading std::chrono::steady_clock twice, and check the percentiles of
+   //    a buf::Histogram against the exact percentiles of the same values
+   Result<void> Benchmarks::benchProfiler()
+   {
+      constexpr std::int32_t scopes_per_call = 1000;
+
+      std::cout << "Profiler: cost of one timed scope, and histogram percentiles against exact ones" << std::endl;
+      if (!ProfilingEnabled)
+         std::cout << "   timed scopes: removed (built with BOLT_DISABLE_PROFILING defined)" << std::endl;
+
+      Histogram scope_histogram;
+      const double scope_ns = averageNanoseconds([&]()
+      {
+         for (std::int32_t scope = 0; scope < scopes_per_call; ++scope)
+         {
+            BUF_PROFILE_SCOPE(scope_histogram);
+         }
+      }) / scopes_per_call;
+
+      std::uint64_t steady_clock_total = 0;   // Used, so the clock reads are not optimized away
+      const double steady_clock_ns = averageNanoseconds([&]()
+      {
+         for (std::int32_t scope = 0; scope < scopes_per_call; ++scope)
+         {
+            const auto start = std::chrono::steady_clock::now();
+            steady_clock_total += static_cast<std::uint64_t>((std::chrono::steady_clock::now() - start).count());
+         }
+      }) / scopes_per_call;
+
+      std::cout << std::format("{:>24} {:>10.2f} ns", "BUF_PROFILE_SCOPE", scope_ns) << std::endl;
+      std::cout << std::format("{:>24} {:>10.2f} ns", "steady_clock::now() x2", steady_clock_ns) << std::endl;
+      std::cout << std::format("{:>24} {:>10.3f}", "CycleClock ticks/ns", CycleClock::ticksPerNanosecond()) << std::endl;
+
+      // Values spread over several powers of two (like frame phase times from microseconds to milliseconds, in ticks)
+      std::mt19937_64 random{ 42 };
+      std::lognormal_distribution<double> random_ticks{ 11.0, 1.5 };
+      std::vector<std::uint64_t> values(200'000);
+      Histogram histogram;
+      for (std::uint64_t& value : values)
+      {
+         value = static_cast<std::uint64_t>(random_ticks(random));
+         histogram.record(value);
+      }
+      std::sort(values.begin(), values.end());
+
+      std::cout << std::format("{:>24} {:>12} {:>12} {:>10}", "percentile", "histogram", "exact", "error") << std::endl;
+      for (const double fraction : { 0.5, 0.9, 0.99, 0.999 })
+      {
+         const std::uint64_t exact = values[static_cast<std::size_t>(fraction * values.size() + 0.5) - 1];
+         const std::uint64_t estimate = histogram.percentile(fraction);
+         const double error = (exact > 0) ? (static_cast<double>(estimate) - exact) / exact : 0.0;
+         std::cout << std::format("{:>24} {:>12} {:>12} {:>9.2f}%", std::format("p{}", 100.0 * fraction), estimate, exact, 100.0 * error) << std::endl;
+
+         if (std::abs(error) > 1.0 / Histogram::SubBucketCount)
+            return buf::unexpected(std::format("Histogram p{} is {} (exact {}), more than its precision off.", 100.0 * fraction, estimate, exact));
+      }
+
+      return Result<void>{};
+   }
+} // End namespace bolt::game_engine
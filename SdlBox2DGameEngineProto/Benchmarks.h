@@ -0,0 +1,51 @@
+#pragma once
+// Purpose: Benchmarks of the engine's hot paths, run from the command line with "--bench <name>".  No window is opened, so 
+//          they also run on machines with no display.  Results are printed to stdout.
+//
+
+#include "bolt_buf.h"
+
+#include <string_view>
+
+namespace bolt::game_engine
+{
+   class Benchmarks
+   {
+   public:
+      // Run the named benchmark, or every benchmark if the name is "all"
+      static buf::Result<void> run(std::string_view name);
+
+   private:
+      // Compare transforming the points of 1k, 10k and 100k triangles to world coordinates: glm (per body matrix), 
+      // scalar buf::transformPointsBatchScalar() and SIMD buf::transformPointsBatch().  Returns an error if the SIMD points are
+      // further than TransformTolerance from the scalar ones.
+      static buf::Result<void> benchTransformPoints();
+      // Check buf::calculateCentroid() on known (clockwise, counter-clockwise and degenerate) polygons, then measure the 
+      // throughput of buf::calculateCentroidsBatch().  Returns an error if a check fails.
+      static buf::Result<void> benchCentroids();
+      // Create and destroy 1k to 1M triangles in a bare Box2D world, in bursts, as a steady trickle, and as churn with a stable 
+      // population.  Each body is built from scratch (like Simulation::addPolygon()) and from a prefab (like Engine::spawnMany()).
+      // Reports ns per operation, heap allocations per operation (operator new and Box2D's b2Alloc()) and how much the process's
+      // resident memory grew over each run.
+      static buf::Result<void> benchSpawnStorm();
+      // Time b2World::Step() on scenes of 250 to 4000 bodies (triangles falling on the platform, a stacked pyramid, and a sparse 
+      // field), at the engine's solver iterations and then a sweep of other iterations.  Prints CSV: ms per step, touching 
+      // contacts per step and awake bodies, so results can be compared across commits.
+      static buf::Result<void> benchStepThroughput();
+      // Step 16 or more independent worlds (400 triangles falling on a platform in each) in parallel with a SimulationHost, on 
+      // 1, 2, 4, ... threads up to the number of cores.  Prints CSV: world steps per second, and the speedup over one thread.
+      static buf::Result<void> benchParallelWorlds();
+      // Capture and restore WorldSnapshots of 1k to 16k triangles piled on the platform, and compare restoring with building 
+      // the scene again from scratch.  Reports the snapshot's size, the times, and the heap allocations of each.  Returns an
+      // error if a restored world differs from the captured one.
+      static buf::Result<void> benchSnapshot();
+      // Step two identical worlds of 1k to 16k triangles falling on the platform side by side, checking their state hashes 
+      // (TransformMirror::stateHash()) match after every step, then compare the time to hash the state with the time of a 
+      // step.  Returns an error if the hashes differ, or if the SIMD hash differs from the scalar one.
+      static buf::Result<void> benchStateHash();
+      // Measure the cost of a timed scope (BUF_PROFILE_SCOPE) against reading std::chrono::steady_clock twice, and check the 
+      // percentiles of a buf::Histogram against the exact percentiles of the same values.  Returns an error if a percentile
+      // is further off than the histogram's precision.
+      static buf::Result<void> benchProfiler();
+   };
+} // End namespace bolt::game_engine
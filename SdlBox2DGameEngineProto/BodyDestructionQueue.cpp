@@ -0,0 +1,20 @@
+
+#include "BodyDestructionQueue.h"
+
+#include <algorithm>
+
+namespace bolt::game_engine
+{
+   // Purpose: Take every marked body (once each, sorted by address) as the batch to destroy, and start a new (empty) set of marks.
+   //    The pending and batch vectors swap buffers, so neither is ever freed and reallocated.
+   std::span<b2Body* const> BodyDestructionQueue::takeBatch()
+   {
+      batch.clear();
+      std::swap(batch, pending);
+
+      std::sort(batch.begin(), batch.end());
+      batch.erase(std::unique(batch.begin(), batch.end()), batch.end());
+
+      return batch;
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,35 @@
+#pragma once
+// Purpose: Bodies must not be destroyed inside Box2D callbacks (or while anything is iterating over them), so they are marked 
+//          for destruction instead, and destroyed together as one batch after the physics step.  The queue's memory is kept 
+//          and reused, so a burst of thousands of removals does not allocate (once the queue has grown to fit a burst).
+//
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   class BodyDestructionQueue
+   {
+   public:
+      static constexpr std::size_t DefaultCapacity = 1024;
+
+      BodyDestructionQueue() { pending.reserve(DefaultCapacity); batch.reserve(DefaultCapacity); };
+
+      // Mark a body to be destroyed with the next batch.  Marking a body more than once is fine (it is only destroyed once).
+      void markForDestruction(b2Body* body) { pending.push_back(body); };
+      // Number of marks (including any duplicates) waiting for the next batch
+      std::size_t pendingCount() const { return pending.size(); };
+
+      // Take every marked body (once each, sorted by address) as the batch to destroy, and start a new (empty) set of marks.
+      //    Note: The returned span is valid until the next call to takeBatch().
+      std::span<b2Body* const> takeBatch();
+
+   private:
+      std::vector<b2Body*> pending;   // Marked bodies (may contain duplicates)
+      std::vector<b2Body*> batch;     // The last batch taken (sorted, no duplicates)
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,77 @@
+
+#include "BodyMetadata.h"
+
+#include <cassert>
+
+namespace bolt::game_engine
+{
+   // Purpose: Add an entry for the body, and store its handle in the body's user data.  Returns the body's handle.
+   BodyHandle BodyMetadataTable::add(b2Body* body, const BodyMetadata& metadata)
+   {
+      assert(body != nullptr);
+
+      BodyHandle handle;
+      if (!free_handles.empty())
+      {
+         handle = free_handles.back();
+         free_handles.pop_back();
+      }
+      else
+      {
+         handle = static_cast<BodyHandle>(entries.size());
+         entries.emplace_back();
+      }
+
+      entries[handle] = metadata;
+      entries[handle].body = body;
+
+      static_assert(sizeof(uintptr_t) >= sizeof(BodyHandle)); // Make sure that we can save a handle in the user data
+      body->GetUserData().pointer = static_cast<uintptr_t>(handle);
+
+      return handle;
+   }
+
+   // Purpose: Remove the body's entry (call when the body is destroyed).  The handle may then be reused.
+   void BodyMetadataTable::remove(BodyHandle handle)
+   {
+      assert(handle != InvalidBodyHandle && handle < entries.size() && entries[handle].body != nullptr);
+
+      entries[handle] = BodyMetadata{};
+      free_handles.push_back(handle);
+   }
+
+   // Purpose: Remove every entry
+   void BodyMetadataTable::clear()
+   {
+      entries.resize(1);
+      free_handles.clear();
+   }
+
+   // Purpose: Remove every entry, and make the table capacity entries long with no free handles
+   void BodyMetadataTable::reset(std::size_t capacity)
+   {
+      assert(capacity >= 1);
+
+      entries.assign(capacity, BodyMetadata{});
+      free_handles.clear();
+   }
+
+   // Purpose: Add an entry for the body at an unused handle, and store the handle in the body's user data
+   void BodyMetadataTable::addAt(BodyHandle handle, b2Body* body, const BodyMetadata& metadata)
+   {
+      assert(body != nullptr);
+      assert(handle != InvalidBodyHandle && handle < entries.size() && entries[handle].body == nullptr);
+
+      entries[handle] = metadata;
+      entries[handle].body = body;
+      body->GetUserData().pointer = static_cast<uintptr_t>(handle);
+   }
+
+   // Purpose: Add an unused handle to the end of the free handles
+   void BodyMetadataTable::addFreeHandle(BodyHandle handle)
+   {
+      assert(handle != InvalidBodyHandle && handle < entries.size() && entries[handle].body == nullptr);
+
+      free_handles.push_back(handle);
+   }
+} // End namespace bolt::game_engine
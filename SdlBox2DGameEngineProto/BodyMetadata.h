@@ -0,0 +1,90 @@
+#pragma once
+// Purpose: Engine owned (gameplay) data about each body, kept in one dense table indexed by a small BodyHandle.  The handle is 
+//          stored in the body's Box2D user data, so classifying a body (e.g. in a contact callback) is one indexed load.
+//
+
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   // Index of a body's entry in the BodyMetadataTable.  Handles of removed bodies are reused for new bodies.
+   using BodyHandle = std::uint32_t;
+   constexpr BodyHandle InvalidBodyHandle = 0;   // Entry 0 is never used, so a body with no user data has no handle
+
+   enum class BodyKind : std::uint8_t 
+   { 
+      Static,    // Rigid, fixed platforms (that probably never move)
+      Dynamic,   // Bodies that fall and bounce around (and that we may want to delete)
+   };
+
+   enum class RenderStyle : std::uint8_t { Platform, Block, Ball };
+
+   struct BodyMetadata
+   {
+      // Bit flags (see flags)
+      enum Flags : std::uint8_t
+      {
+         MarkedForDestruction = 1 << 0,   // Will be destroyed after the current step
+      };
+
+      static constexpr float Forever = std::numeric_limits<float>::infinity();
+
+      b2Body* body = nullptr;             // The Box2D body (nullptr for an unused entry)
+      float lifetime = Forever;           // Seconds (of simulated time) left before the body is destroyed
+      BodyKind kind = BodyKind::Static;
+      std::uint8_t team = 0;              // Which side the body is on (zero for none)
+      RenderStyle render_style = RenderStyle::Block;
+      std::uint8_t flags = 0;             // Flags
+   };
+
+   class BodyMetadataTable
+   {
+   public:
+      // Add an entry for the body, and store its handle in the body's user data.  Returns the body's handle.
+      BodyHandle add(b2Body* body, const BodyMetadata& metadata);
+      // Remove the body's entry (call when the body is destroyed).  The handle may then be reused.
+      void remove(BodyHandle handle);
+      // Remove every entry
+      void clear();
+      // Remove every entry, and make the table capacity entries long with no free handles.  Then add each body back at its
+      // handle with addAt(), and the free handles with addFreeHandle().  Used to restore a saved table (e.g. from a WorldSnapshot).
+      void reset(std::size_t capacity);
+      // Add an entry for the body at an unused handle, and store the handle in the body's user data
+      void addAt(BodyHandle handle, b2Body* body, const BodyMetadata& metadata);
+      // Add an unused handle to the end of the free handles (see freeHandles())
+      void addFreeHandle(BodyHandle handle);
+
+      // Return the handle stored in a body's user data (InvalidBodyHandle if the body was not added)
+      static BodyHandle handleOf(b2Body* body) { return static_cast<BodyHandle>(body->GetUserData().pointer); };
+
+      BodyMetadata& operator[](BodyHandle handle) { return entries[handle]; };
+      const BodyMetadata& operator[](BodyHandle handle) const { return entries[handle]; };
+
+      // Number of entries, including unused ones (handles are less than this)
+      std::size_t capacity() const { return entries.size(); };
+      // Number of bodies in the table
+      std::size_t size() const { return entries.size() - 1 - free_handles.size(); };
+      // Handles of removed bodies, in the order they will be reused (last first)
+      std::span<const BodyHandle> freeHandles() const { return free_handles; };
+
+      // Call func(BodyHandle, BodyMetadata&) for every body in the table
+      template <typename Func>
+      void forEach(Func&& func)
+      {
+         for (BodyHandle handle = 1; handle < entries.size(); ++handle)
+         {
+            if (entries[handle].body != nullptr)
+               func(handle, entries[handle]);
+         }
+      }
+
+   private:
+      std::vector<BodyMetadata> entries{ BodyMetadata{} };   // Starts with the never used entry 0
+      std::vector<BodyHandle> free_handles;                  // Handles of removed bodies, to reuse
+   };
+} // End namespace bolt::game_engine
@@ -1,49 +1,123 @@
 #pragma once
 // Purpose: ContactListener is derived from a Box2D b2ContactListener to callbacks on collisions from the Box2D "world" object.
+//          The callbacks happen inside b2World::Step(), so they only record compact ContactEvents in a preallocated ring buffer.  
+//          Gameplay code drains the events after the step.
 //
+#include "bolt_buf_ring_buffer.h"
+#include "bolt_buf_profile.h"
+#include "BodyMetadata.h"
+
 #include <Box2D/Box2D.h>
 
+#include <atomic>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 
-extern const int StaticType;  // @@@ TODO: Need to remove
-extern const int DynamicType; // @@@ TODO: Need to remove
+// A contact between two bodies, recorded during the physics step
+struct ContactEvent
+{
+   enum class Type : std::uint8_t 
+   { 
+      Begin,   // The bodies started touching
+      End,     // The bodies stopped touching (or one was destroyed)
+      Impact,  // The solver pushed the bodies apart with at least the listener's impact threshold of impulse
+   };
+
+   bolt::game_engine::BodyHandle body_a;   // The bodies' entries in the BodyMetadataTable
+   bolt::game_engine::BodyHandle body_b;
+   Type type;
+   b2Vec2 point;          // World point of contact (zero for End events)
+   float normal_impulse;  // Largest normal impulse between the bodies (Impact events only, otherwise zero)
+};
 
 // ContactListener is derived from a Box2D b2ContactListener to callbacks on collisions from the Box2D "world" object.
 //    #1 Need to make a derived class of the b2ContactListener to get callbacks on collisions
 class ContactListener : public b2ContactListener
 {
+public:
+   static constexpr std::size_t DefaultEventCapacity = 4096;
+   static constexpr float DefaultImpactThreshold = 0.1f;   // Newton-seconds: well above the impulse that holds a triangle at rest
+
+   explicit ContactListener(std::size_t event_capacity = DefaultEventCapacity) : events(event_capacity) {};
+
+   // Call func(const ContactEvent&) on every event recorded since the last drain (oldest first), and remove them.  
+   //    Note: Call after b2World::Step() returns (not from another thread while stepping), so the bodies are still valid.
+   template <typename Func>
+   std::size_t drainEvents(Func&& func) { return events.drain(std::forward<Func>(func)); };
+
+   // Number of events dropped (ever) because the event buffer was full when they happened
+   std::uint64_t getOverflowCount() const { return overflow_count.load(std::memory_order_relaxed); };
+   // Only record an Impact event when the normal impulse between two bodies is at least impact_threshold
+   void setImpactThreshold(float _impact_threshold) { impact_threshold = _impact_threshold; };
+   // Turn recording events on or off.  Turn it off while destroying bodies: b2World::DestroyBody() calls EndContact(), and an 
+   // event holding the handle of a destroyed body (which may be reused by a new body) must never reach the event buffer.
+   void setRecording(bool _recording) { recording = _recording; };
+   // Total time (ever) spent in the callbacks, in buf::CycleClock ticks (stays zero if built with BOLT_DISABLE_PROFILING)
+   std::uint64_t getCallbackTicks() const { return callback_ticks; };
+   // Set the table used to classify bodies (must be set before the world is stepped)
+   void setBodyMetadata(const bolt::game_engine::BodyMetadataTable* _body_metadata) { body_metadata = _body_metadata; };
+
+private:
+   // Return true if the body is one we want contact events for (i.e. a dynamic body that we may want to delete)
+   bool isDynamicType(bolt::game_engine::BodyHandle handle) const
+   {
+      assert(body_metadata != nullptr);
+      return handle != bolt::game_engine::InvalidBodyHandle && (*body_metadata)[handle].kind == bolt::game_engine::BodyKind::Dynamic;
+   }
+
+   // Add an event to the buffer, or count it as dropped if the buffer is full
+   void pushEvent(const ContactEvent& event)
+   {
+      if (!recording)
+         return;
+
+      if (!events.tryPush(event))
+         overflow_count.fetch_add(1, std::memory_order_relaxed);
+   }
+
    /// Called when two fixtures begin to touch.
    void BeginContact(b2Contact* contact) override
    {
       // std::cout << __func__ << std::endl;
+      BUF_PROFILE_ACCUMULATE(callback_ticks);
 
-      auto body_a = contact->GetFixtureA()->GetBody();
-      auto body_b = contact->GetFixtureB()->GetBody();
+      const auto body_a = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureA()->GetBody());
+      const auto body_b = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureB()->GetBody());
 
       // #1
       // !! Caution: Don't delete bodies (or anything) here.  Set a flag and do it elsewhere.
+      //    Also, don't print (or do anything slow) here, it happens inside the physics step.  Just record the event.
+      if (!isDynamicType(body_a) && !isDynamicType(body_b))
+         return;
 
-      // Get the type of body A
-      const auto& a_user_data = body_a->GetUserData();
-      auto a_user_int_ptr = (int*)a_user_data.pointer;
-      auto a_type = (a_user_int_ptr != nullptr) ? *a_user_int_ptr : StaticType;
-
-      if (a_type == DynamicType)
-         std::cout << "Detected collision: Dynamic body: Maybe delete body A based on type" << std::endl;
+      // A contact with no manifold points (e.g. a sensor overlap) leaves the world manifold unset, so the point is then midway
+      // between the two bodies instead
+      b2Vec2 point;
+      const int32 point_count = contact->GetManifold()->pointCount;
+      if (point_count > 0)
+      {
+         b2WorldManifold world_manifold;
+         contact->GetWorldManifold(&world_manifold);
+         point = (point_count > 1) ? 0.5f * (world_manifold.points[0] + world_manifold.points[1]) : world_manifold.points[0];
+      }
+      else
+         point = 0.5f * (contact->GetFixtureA()->GetBody()->GetPosition() + contact->GetFixtureB()->GetBody()->GetPosition());
 
-      // Get the type of body A
-      const auto& b_user_data = body_b->GetUserData();
-      auto b_user_int_ptr = (int*)b_user_data.pointer;
-      auto b_type = (b_user_int_ptr != nullptr) ? *b_user_int_ptr : StaticType;
-
-      if (b_type == DynamicType)
-         std::cout << "Detected collision: Dynamic body: Maybe delete body B based on type" << std::endl;
+      pushEvent({ body_a, body_b, ContactEvent::Type::Begin, point, 0.0f });
    };
 
    /// Called when two fixtures cease to touch.
    void EndContact(b2Contact* contact) override
    {
       // std::cout << __func__ << std::endl;
+      BUF_PROFILE_ACCUMULATE(callback_ticks);
+
+      const auto body_a = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureA()->GetBody());
+      const auto body_b = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureB()->GetBody());
+
+      if (isDynamicType(body_a) || isDynamicType(body_b))
+         pushEvent({ body_a, body_b, ContactEvent::Type::End, b2Vec2(0.0f, 0.0f), 0.0f });
    };
 
    /// This is called after a contact is updated. This allows you to inspect a
@@ -51,6 +125,7 @@ class ContactListener : public b2ContactListener
    void PreSolve(b2Contact* contact, const b2Manifold* oldManifold) override
    {
       // std::cout << __func__ << std::endl;
+      BUF_PROFILE_ACCUMULATE(callback_ticks);
       auto body_a = contact->GetFixtureA()->GetBody();
       auto body_b = contact->GetFixtureB()->GetBody();
 
@@ -67,5 +142,31 @@ class ContactListener : public b2ContactListener
    void PostSolve(b2Contact* contact, const b2ContactImpulse* impulse) override
    {
       // std::cout << __func__ << std::endl;
+      BUF_PROFILE_ACCUMULATE(callback_ticks);
+
+      float max_normal_impulse = 0.0f;
+      for (int32 index = 0; index < impulse->count; ++index)
+         max_normal_impulse = b2Max(max_normal_impulse, impulse->normalImpulses[index]);
+
+      if (max_normal_impulse < impact_threshold)
+         return;
+
+      const auto body_a = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureA()->GetBody());
+      const auto body_b = bolt::game_engine::BodyMetadataTable::handleOf(contact->GetFixtureB()->GetBody());
+      if (!isDynamicType(body_a) && !isDynamicType(body_b))
+         return;
+
+      b2WorldManifold world_manifold;
+      contact->GetWorldManifold(&world_manifold);
+      const b2Vec2 point = (impulse->count > 1) ? 0.5f * (world_manifold.points[0] + world_manifold.points[1]) : world_manifold.points[0];
+
+      pushEvent({ body_a, body_b, ContactEvent::Type::Impact, point, max_normal_impulse });
    };
+
+   buf::SpscRingBuffer<ContactEvent> events;           // Recorded during the step, drained after it
+   std::atomic<std::uint64_t> overflow_count{ 0 };     // Events dropped because the buffer was full
+   const bolt::game_engine::BodyMetadataTable* body_metadata{ nullptr };   // Classifies the bodies (owned by the engine)
+   std::uint64_t callback_ticks{ 0 };                  // Time spent in the callbacks (only touched by the stepping thread)
+   float impact_threshold{ DefaultImpactThreshold };
+   bool recording{ true };
 };
@@ -13,7 +13,6 @@
 //    glGetFloatv(GL_MODELVIEW_MATRIX, model_view_matrix);
 //    std::cout << "model: " << printMatrixAsLines(model_view_matrix) << std::endl;
 
-#include "ContactListener.h"  // #1 We need custom class for collision callbacks
 #include "bolt_buf.h"
 #include "Engine.h"
 
@@ -31,6 +30,10 @@
 #include <string>
 #include <iostream>
 #include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <csignal>
 #include <format>
 #include <iostream>
 #include <string>
@@ -46,26 +49,26 @@ using namespace std::string_literals;
 namespace bolt::game_engine
 {
    using namespace buf;
-   Engine::ScreenMode Engine::screen_mode = Engine::ScreenMode::None;
+   Engine* Engine::glut_engine{ nullptr };   // The engine that configured the (one) glut window, or null
 
-   std::int16_t Engine::window_width = screen_width_default;    // Current window in pixels
-   std::int16_t Engine::window_height = screen_height_default;  // Current window in pixels
-
-   // Show less of the world as the window gets smaller ...
-   float Engine::x_world_display_max = (x_world_display_max_nominal * window_width) / screen_width_default;
-   float Engine::y_world_display_max = (y_world_display_max_nominal * window_height) / screen_height_default;
-
-   ContactListener Engine::contact_listener{};   // #1 Only need ONE instance of the contact listener to receive all collision callbacks
-   b2World* Engine::world{ nullptr };                     // The Box2D world of objects
+   namespace
+   {
+      // Set by Ctrl-C (SIGINT) while an engine runs, so its loop ends and the run is shut down normally (input log saved, trace closed)
+      volatile std::sig_atomic_t stop_requested = 0;
 
-   // Record the results of a configuration attempt. Contains an error string if not configured 
-   Result<void> Engine::config_result{ buf::unexpected("There was no attempt to configure the engine."s) };
+      // Purpose: Ask the running loop to end (the SIGINT handler while an engine runs)
+      void requestStop(int)
+      {
+         stop_requested = 1;
+      }
+   }
 
-   // #1 The tutorial used void pointers to "user data" with user data being int's.  So we need a couple ints to point to, where
-   //    the value of the int indicates our custom type - i.e. it is either a "static" box (the platform where boxes land),
-   //    or it is a "dynamic" box that we may want to delete.
-   // const int Engine::StaticType = 0;     // We make either static boxes
-   // const int Engine::DynamicType = 1;    // or dynamic boxes
+   // Purpose: Stop glut calling back into an engine that no longer exists
+   Engine::~Engine()
+   {
+      if (glut_engine == this)
+         glut_engine = nullptr;
+   }
 
       // Purpose: Configure the graphics 
    Result<void> Engine::configureGraphics(ScreenMode _screen_mode)
@@ -73,7 +76,11 @@ namespace bolt::game_engine
       Result<void> result; // Defaults to successful result
 
       assert(_screen_mode != ScreenMode::None);
+      if (glut_engine != nullptr && glut_engine != this)
+         return buf::unexpected("Another engine already has the (one) glut window."s);
+
       screen_mode = _screen_mode;
+      glut_engine = this;   // Glut's callbacks (static functions) forward to this engine
 
       int dummy_command_lines_args = 0;
       glutInit(&dummy_command_lines_args, nullptr); // Init with no arguments: *OR* you can pass in command line arguments via "glutInit(&argc, args);"
@@ -95,6 +102,9 @@ namespace bolt::game_engine
          glutCreateWindow("Bolt Game Engine"); // creating the window
       }
 
+      // Closing the window returns from glutMainLoop() (rather than glut calling exit()), so runEngine() shuts down normally
+      glutSetOption(GLUT_ACTION_ON_WINDOW_CLOSE, GLUT_ACTION_GLUTMAINLOOP_RETURNS);
+
       //// Initialize Modelview Matrix
       glMatrixMode(GL_MODELVIEW);
       glLoadIdentity();
@@ -116,11 +126,14 @@ namespace bolt::game_engine
       // glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
       // glHint(GL_POLYGON_SMOOTH_HINT, GL_NICEST);
 
+      if (vsync)
+         enableVSync();
+
       //// TODO: @@@ Figure a better way to setup callbacks
-      auto render_lamda = []() { render();  };
-      glutDisplayFunc(render_lamda); //use the display function to draw everything
-      glutIdleFunc(render_lamda); //update any variables in display, display can be changed to anything, as long as you move the variables to be updated, in this case, angle++;
-      glutReshapeFunc(reshapeOrtho); //reshape the window accordingly
+      //    Note: There is deliberately no glutIdleFunc().  The display is only redrawn when runMainLoop() (or glut, on an
+      //    expose or reshape) posts a redisplay, rather than redrawing the same frame as fast as the CPU allows.
+      glutDisplayFunc(displayCallback); //use the display function to draw everything
+      glutReshapeFunc(reshapeCallback); //reshape the window accordingly
 
       glutMouseFunc(mouseEventCallback);
       glutKeyboardFunc(keyboardEventCallback);
@@ -135,16 +148,48 @@ namespace bolt::game_engine
       return result;
    }
 
+   // Purpose: Ask the driver to wait for vertical sync when swapping buffers (if the platform supports it)
+   void Engine::enableVSync()
+   {
+#ifdef _WIN32
+      const char* swap_interval_name = "wglSwapIntervalEXT";
+#else
+      const char* swap_interval_name = "glXSwapIntervalSGI";
+#endif
+      using SwapIntervalFunc = int (APIENTRY*)(int interval);
+      auto swap_interval = reinterpret_cast<SwapIntervalFunc>(glutGetProcAddress(swap_interval_name));
+
+      if (swap_interval != nullptr)
+         swap_interval(1);   // Swap at most once per vertical refresh
+      else
+         std::cerr << "VSync not supported by the OpenGL driver: " << swap_interval_name << " not found" << std::endl;
+   }
+
    // Purpose: Configure the engine before starting it
    Result<void> Engine::configureEngine(ScreenMode _screen_mode)
    {
+      if (_screen_mode == ScreenMode::Headless)
+      {
+         // No graphics at all, so nothing (glut/OpenGL) to configure
+         screen_mode = _screen_mode;
+         config_result = Result<void>{};
+      }
       // Configure the graphics.  If there is an err, return the (error) result
-      if (config_result = configureGraphics(_screen_mode); !config_result)
+      else if (config_result = configureGraphics(_screen_mode); !config_result)
+         return config_result;
+
+      // Add the standard prefabs.  If there is an err, return the (error) result
+      if (config_result = initPrefabs(); !config_result)
          return config_result;
 
       // Initialize the Box2D world and create/place the static objects.
       initBox2DWorld();
 
+      // Save the starting scene, so resetWorld() can restore it rather than building it again (if it can't be saved, resetWorld()
+      // builds it again, so carry on)
+      if (auto snapshot_result = start_snapshot.capture(simulation); !snapshot_result)
+         std::cerr << "Start snapshot not saved (reset will rebuild the scene): " << snapshot_result.error() << std::endl;
+
       return config_result;
    }
 
@@ -153,12 +198,45 @@ namespace bolt::game_engine
    {
       Result<void> result; // Initialize to non-error 
 
+      // The settings that change how the run plays out, for the input log
+      record_settings.time_step = simulation.getTimeStep();
+      record_settings.spawn_lifetime = simulation.getSpawnLifetime();
+      record_settings.destroy_on_contact = simulation.getDestroyOnContact();
+      record_settings.fixed_iterations = !simulation.getAdaptiveIterations();
+      record_settings.spawn_interval_steps = (screen_mode == ScreenMode::Headless) ? headless_spawn_interval_steps : 0;
+      record_settings.spawn_batch = headless_spawn_batch;
+
+      if (trace_on_start)
+         toggleTraceRecording();
+
+      // Ctrl-C ends the loop (rather than the process), so the run is shut down normally
+      stop_requested = 0;
+      std::signal(SIGINT, requestStop);
+
+      if (screen_mode == ScreenMode::Headless)
+      {
+         runHeadlessLoop();
+         std::signal(SIGINT, SIG_DFL);
+         saveInputRecording();
+         if (TraceRecorder::isRecording())
+            toggleTraceRecording();
+         frame_profiler.report(std::cout);
+         return result;
+      }
+
       // Setup a timer (in milliseconds), then call the runMainLoop() function. 
       //  - val is just a user provided value so the user can (potentially) identify the reason a timer when off
-      glutTimerFunc(1000 / ScreenFramesPerSecond, runMainLoop, 0 /*val*/);
+      last_loop_time = LoopClock::now();
+      reportFrameStats(last_loop_time);   // Start gathering frame stats
+      glutTimerFunc(1000 / ScreenFramesPerSecond, timerCallback, 0 /*val*/);
 
       // Run the world.
-      glutMainLoop(); //Start GLUT main loop
+      glutMainLoop(); //Start GLUT main loop (returns when the window is closed, ESC is pressed, or on Ctrl-C)
+      std::signal(SIGINT, SIG_DFL);
+      saveInputRecording();
+      if (TraceRecorder::isRecording())
+         toggleTraceRecording();
+      frame_profiler.report(std::cout);
 
       glutLeaveGameMode(); //set the resolution how it was
       SDL_Quit(); //Quit/cleanup SDL subsystems
@@ -166,75 +244,183 @@ namespace bolt::game_engine
       return result;
    }
 
-   // Purpose: Add a new polygon to the (Box2D) world of object.
-   //       - if true the object bounce around in the physical world.  
-   //       - If false the object is "static" and acts like a rigid, fixed platform (that probably never moves in the scene).
-   b2Body* Engine::addPolyToWorld(float x_center_world, float y_center_world, const std::vector<buf::Vec2>& verts, bool dynamic_object)
+   // Purpose: Put the world back to the starting scene (restored from a snapshot of it), without reconfiguring the graphics
+   void Engine::resetWorld()
    {
-      // https://gamedev.stackexchange.com/questions/1496/using-the-box2d-polygon-set-function
+      if (start_snapshot.empty() || !start_snapshot.restore(simulation))
+         initBox2DWorld();   // Build it again (the slow way)
+
+      // A new run: its inputs are stamped (and recorded) from step zero again
+      input_queue.clear();
+      input_log.clear();
+      step_count = 0;
+      state_hash = 0;
+      invalidate();
+   }
 
-      b2BodyDef bodydef;
-      bodydef.position.Set(x_center_world, y_center_world);
-      bodydef.type = (dynamic_object) ? b2_dynamicBody : b2_staticBody;
+   // Purpose: Run in deterministic (lockstep) mode: fixed solver iterations, and every body's state hashed after each step
+   void Engine::setDeterministic(bool _deterministic)
+   {
+      deterministic = _deterministic;
+      if (deterministic)
+         simulation.setAdaptiveIterations(false);   // Adaptive iterations follow the wall-clock, which differs every run
 
-      b2Body* body = world->CreateBody(&bodydef);
+      state_hash = deterministic ? simulation.getTransformMirror().stateHash() : 0;
+   }
 
-      b2PolygonShape shape;
-      assert(verts.size() <= 8); // Polygons are limited to 8 vertices 
+   // Purpose: Replay the inputs recorded in a log file (set before runEngine(), with ScreenMode::Headless)
+   //    The recorded run's settings replace the engine's, and every event is queued for its step up front.  The solver 
+   //    iterations are always fixed, so the replay plays out the same way however fast the machine is.
+   Result<void> Engine::setInputReplay(const std::string& path)
+   {
+      auto settings_result = input_log.load(path);
+      if (!settings_result)
+         return buf::unexpected(settings_result.error());
+      if (settings_result->step_count <= 0)
+         return buf::unexpected(std::format("Input log {} recorded no steps.", path));
+
+      input_queue.clear();
+      if (auto replay_result = input_log.replayInto(input_queue); !replay_result)
+         return replay_result;
+
+      replaying = true;
+      replay_settings = *settings_result;
+      simulation.setTimeStep(replay_settings.time_step);
+      simulation.setSpawnLifetime(replay_settings.spawn_lifetime);
+      simulation.setDestroyOnContact(replay_settings.destroy_on_contact);
+      setDeterministic(replay_settings.state_hash != 0);
+      simulation.setAdaptiveIterations(false);
+      setHeadlessOptions(replay_settings.step_count, replay_settings.spawn_interval_steps, replay_settings.spawn_batch);
+
+      std::cout << std::format("Replaying {}: {} steps, {} inputs in {} bytes", path, replay_settings.step_count, input_log.eventCount(), input_log.size()) << std::endl;
+      if (!replay_settings.fixed_iterations)
+         std::cout << "Note: the run was recorded with adaptive solver iterations, so the replay (with fixed iterations) may play out differently" << std::endl;
+
+      return Result<void>{};
+   }
 
-      shape.Set(cvert(&verts[0]), (int32)verts.size());
+   // Purpose: Write the input log of the run so far (if recording), replacing the last one written, and keep recording
+   //    Called about once a second, so a run that is killed (or never ends) still leaves a log that replays up to that point.
+   void Engine::checkpointInputRecording()
+   {
+      if (input_record_path.empty())
+         return;
 
-      b2FixtureDef fixture_def;
-      fixture_def.shape = &shape;   // Note: "shape" is specifically documented to state that it will be cloned, so can be on stack.
-      fixture_def.density = 1.0;
+      record_settings.step_count = step_count;
+      record_settings.state_hash = deterministic ? state_hash : 0;
+      if (auto save_result = input_log.save(input_record_path, record_settings); !save_result)
+         std::cerr << "Input log checkpoint not saved: " << save_result.error() << std::endl;
+   }
 
-      body->CreateFixture(&fixture_def);
+   // Purpose: Write the input log of the run (if recording), once, when the run ends
+   void Engine::saveInputRecording()
+   {
+      if (input_record_path.empty())
+         return;
 
-      auto& user_data = body->GetUserData();
-      assert(sizeof(uintptr_t) == sizeof(&DynamicType)); // Make sure that we can save a pointer to an int in a uintptr_t type.
+      record_settings.step_count = step_count;
+      record_settings.state_hash = deterministic ? state_hash : 0;
+      if (auto save_result = input_log.save(input_record_path, record_settings); save_result)
+         std::cout << std::format("Input log saved to {}: {} steps, {} inputs in {} bytes", input_record_path, step_count, input_log.eventCount(), input_log.size()) << std::endl;
+      else
+         std::cerr << "Input log not saved: " << save_result.error() << std::endl;
 
-      // #1 When a collision happens we need to know the type of the box/body, so save the type via a user data pointer
-      if (dynamic_object)
-         user_data.pointer = (uintptr_t)&DynamicType;
+      input_record_path.clear();   // Saved (or failed) once
+   }
+
+   // Purpose: Start recording the engine's timeline to the trace file, or stop and report how much was recorded
+   void Engine::toggleTraceRecording()
+   {
+      if (TraceRecorder::isRecording())
+      {
+         TraceRecorder::stop();
+         std::cout << std::format("Trace saved to {}: {} events ({} dropped)", trace_path, TraceRecorder::writtenCount(), TraceRecorder::droppedCount()) << std::endl;
+      }
+      else if (auto trace_result = TraceRecorder::start(trace_path); trace_result)
+         std::cout << "Trace recording to " << trace_path << std::endl;
       else
-         user_data.pointer = (uintptr_t)&StaticType;
+         std::cerr << "Trace not recorded: " << trace_result.error() << std::endl;
+   }
 
-      return body;
+   // Purpose: Set the fixed rate the physics is stepped at (independent of the display rate), and the maximum number of 
+   //    physics steps taken per displayed frame to catch up with the wall-clock (any time beyond that is dropped).
+   Result<void> Engine::setPhysicsRate(float steps_per_second, std::int32_t _max_steps_per_frame)
+   {
+      // A rate of zero (or less, or not a number) would make the time step infinite (or negative), and the main loop's 
+      // accumulator arithmetic meaningless
+      if (!(steps_per_second > 0.0f) || !std::isfinite(1.0f / steps_per_second))
+         return buf::unexpected(std::format("The physics rate must be above zero steps per second (not {}).", steps_per_second));
+      if (_max_steps_per_frame <= 0)
+         return buf::unexpected(std::format("The physics steps per frame must be above zero (not {}).", _max_steps_per_frame));
+
+      simulation.setTimeStep(1.0f / steps_per_second);
+      max_steps_per_frame = _max_steps_per_frame;
+      return Result<void>{};
+   }
+
+   // Purpose: Return the color bodies with the render style are drawn in
+   buf::Vec3 Engine::renderStyleColor(RenderStyle render_style)
+   {
+      switch (render_style)
+      {
+      case RenderStyle::Platform: return { 0.6f, 0.6f, 0.6f };
+      case RenderStyle::Block:    return { 1.0f, 0.0f, 0.0f };
+      case RenderStyle::Ball:     return { 1.0f, 0.5f, 0.0f };
+      }
+      return { 1.0f, 1.0f, 1.0f };
    }
 
-   // Purpose: Add a new rectangle to the (Box2D) world of object.
-   //   dynamic_object: 
-   //       - if true the object bounce around in the physical world.  
-   //       - If false the object is "static" and acts like a rigid, fixed platform (that probably never moves in the scene).
-   b2Body* Engine::addRectToWorld(float x_center_world, float y_center_world, float width, float height, bool dynamic_object)
+   // Purpose: Add the standard prefabs (the triangle and ball spawned during play)
+   Result<void> Engine::initPrefabs()
    {
-      b2BodyDef bodydef;
-      bodydef.position.Set(x_center_world, y_center_world);
-      bodydef.type = (dynamic_object) ? b2_dynamicBody : b2_staticBody;
+      prefab_registry.clear();
 
-      b2Body* body = world->CreateBody(&bodydef);
+      // Centroid calculator: https://eguruchela.com/math/calculator/polygon-centroid-point
+      std::vector<buf::Vec2> standard_triangle
+      {
 
-      b2PolygonShape shape;   // Polygons are limited to 8 vertices 
-      shape.SetAsBox(width / 2, height / 2);
+// #define BAD_TRIANGLE         
+#ifdef BAD_TRIANGLE
+         {-0.1333 + 0.5, -0.0667}, {0.0667 + 0.5,-0.0667}, {0.0667 + 0.5,0.1333},  // Bad because points not arranged around centroid
+#else
+         {-0.1333, -0.0667}, {0.0667,-0.0667}, {0.0667,0.1333},
+#endif
+      };
 
-      b2FixtureDef fixture_def;
-      fixture_def.shape = &shape;   // Note: "shape" is specifically documented to state that it will be cloned, so can be on stack.
-      fixture_def.density = 1.0;
+      // Box2D rotates a body about its origin, so move the points to be around their centroid (which fixes the bad triangle)
+      orientToCentroid(standard_triangle);
 
-      body->CreateFixture(&fixture_def);
+      auto triangle_result = prefab_registry.addPolygon(standard_triangle, b2_dynamicBody, 1.0f /*density*/, 
+         { .kind = BodyKind::Dynamic, .render_style = RenderStyle::Block });
+      if (!triangle_result)
+         return buf::unexpected(triangle_result.error());
+      triangle_prefab = *triangle_result;
 
-      auto& user_data = body->GetUserData();
-      assert(sizeof(uintptr_t) == sizeof(&DynamicType)); // Make sure that we can save a pointer to an int in a uintptr_t type.
+      auto ball_result = prefab_registry.addCircle(b2Vec2(0.0f, 0.0f), 0.1f /*radius*/, b2_dynamicBody, 1.0f /*density*/, 
+         { .kind = BodyKind::Dynamic, .render_style = RenderStyle::Ball });
+      if (!ball_result)
+         return buf::unexpected(ball_result.error());
+      ball_prefab = *ball_result;
 
-      // #1 When a collision happens we need to know the type of the box/body, so save the type via a user data pointer
-      if (dynamic_object)
-         user_data.pointer = (uintptr_t)&DynamicType;
-      else
-         user_data.pointer = (uintptr_t)&StaticType;
+      return Result<void>{};
+   }
 
+   // Purpose: Spawn a body from a prefab at the world coordinates.  Returns the new body.
+   b2Body* Engine::spawnPrefab(PrefabHandle prefab, float x_world, float y_world)
+   {
+      b2Body* body = simulation.spawnPrefab(prefab_registry, prefab, x_world, y_world);
+      invalidate();
       return body;
    }
 
+   // Purpose: Spawn a body from the prefab at each world position.  Returns the number of bodies spawned.
+   std::size_t Engine::spawnMany(PrefabHandle prefab, std::span<const b2Vec2> positions)
+   {
+      const std::size_t spawned_count = simulation.spawnMany(prefab_registry, prefab, positions);
+      invalidate();
+      return spawned_count;
+   }
+
    // Purpose: Draw a square. Assumes 4 vertex points using OpenGl   // @@@ Can probably remove this method
    void Engine::drawSquare(b2Vec2* points, b2Vec2 center, float angle)
    {
@@ -251,9 +437,9 @@ namespace bolt::game_engine
    }
 
    // Purpose: Draw a polygon
-   void Engine::drawPoly(const std::span<buf::Vec2>& points, b2Vec2 center, float angle)
+   void Engine::drawPoly(std::span<const buf::Vec2> points, b2Vec2 center, float angle, buf::Vec3 color)
    {
-      glColor3f(1.0, 0.0f, 0.0f);
+      glColor3f(color.x, color.y, color.z);
       glPushMatrix();
       glTranslatef(center.x, center.y, 0.0f);
       glRotatef(angle * 180.0f / (float)M_PI, 0.0f, 0.0f, 1.0f);
@@ -267,41 +453,179 @@ namespace bolt::game_engine
       glPopMatrix();
    }
 
+   // Purpose: Draw a circle (as a fan of triangles).  The circle's center is given in body coordinates.
+   void Engine::drawCircle(b2Vec2 circle_center, float radius, b2Vec2 center, float angle, buf::Vec3 color)
+   {
+      glColor3f(color.x, color.y, color.z);
+      glPushMatrix();
+      glTranslatef(center.x, center.y, 0.0f);
+      glRotatef(angle * 180.0f / (float)M_PI, 0.0f, 0.0f, 1.0f);
+
+      glBegin(GL_TRIANGLE_FAN);
+
+      glVertex2f(circle_center.x, circle_center.y);
+      for (int segment = 0; segment <= BatchRenderer::CircleSegments; ++segment)
+      {
+         const float segment_angle = segment * 2.0f * (float)M_PI / BatchRenderer::CircleSegments;
+         glVertex2f(circle_center.x + radius * std::cos(segment_angle), circle_center.y + radius * std::sin(segment_angle));
+      }
+
+      glEnd();
+      glPopMatrix();
+   }
+
+   namespace
+   {
+      // Collects the transform mirror row of each body that has a fixture in the queried box (via b2World::QueryAABB())
+      //    Note: A body with several fixtures in the box is reported once for each
+      class VisibleRowsCallback : public b2QueryCallback
+      {
+      public:
+         VisibleRowsCallback(const TransformMirror& _transform_mirror, std::vector<std::uint32_t>& _rows) : transform_mirror(_transform_mirror), rows(_rows) {};
+
+         bool ReportFixture(b2Fixture* fixture) override
+         {
+            rows.push_back(transform_mirror.rowOf(BodyMetadataTable::handleOf(fixture->GetBody())));
+            return true;   // Keep going
+         }
+
+      private:
+         const TransformMirror& transform_mirror;
+         std::vector<std::uint32_t>& rows;
+      };
+   }
+
+   // Purpose: Return the transform mirror rows (in order) of the bodies to draw: the ones in the visible rectangle if culling, else all of them
+   //    Note: The broadphase finds the visible bodies in about log(bodies) time, so the cost of drawing follows what is on screen, 
+   //          not how many bodies are in the world.  Its boxes are a little larger than the fixtures, which covers drawing the 
+   //          bodies slightly behind where they are now (interpolated since the previous step).
+   std::span<const std::uint32_t> Engine::findVisibleRows()
+   {
+      const TransformMirror& transform_mirror = simulation.getTransformMirror();
+      visible_rows.clear();
+
+      if (!culling)
+      {
+         for (std::uint32_t row = 0; row < transform_mirror.size(); ++row)
+            visible_rows.push_back(row);
+         return visible_rows;
+      }
+
+      b2AABB visible_box;
+      visible_box.lowerBound.Set(0.0f, 0.0f);
+      visible_box.upperBound.Set(x_world_display_max, y_world_display_max);
+
+      VisibleRowsCallback callback(transform_mirror, visible_rows);
+      simulation.getWorld()->QueryAABB(&callback, visible_box);
+
+      // Each body once, drawn in the same order as without culling
+      std::sort(visible_rows.begin(), visible_rows.end());
+      visible_rows.erase(std::unique(visible_rows.begin(), visible_rows.end()), visible_rows.end());
+      return visible_rows;
+   }
+
    // Purpose: Render the graphics to hidden display buffer, and then swap buffers to show the new display
    void Engine::render()
    {
+      BUF_TRACE_SCOPE("render");
+      redraw_needed = false;
+      last_render_time = LoopClock::now();
+      ++frame_stats.frames_rendered;
+
       glClear(GL_COLOR_BUFFER_BIT); // Clear the hidden (color) buffer with the glClearColor() we setup at initGL() 
 
-      b2Body* body_node_ptr = world->GetBodyList(); // Get the head of list of bodies in the Box2D world
+      const bool batched = (render_path == RenderPath::Batched);
+      if (batched)
+         batch_renderer.begin();
+
+      const BodyMetadataTable& body_metadata = simulation.getBodyMetadata();
+      const TransformMirror& transform_mirror = simulation.getTransformMirror();
+      const auto shapes = simulation.getShapeRegistry().shapes();
+      const auto x = transform_mirror.x();
+      const auto y = transform_mirror.y();
+      const auto angles = transform_mirror.angle();
+      const auto previous_x = transform_mirror.previousX();
+      const auto previous_y = transform_mirror.previousY();
+      const auto previous_angles = transform_mirror.previousAngle();
+      const auto first_shapes = transform_mirror.firstShape();
+      const auto shape_counts = transform_mirror.shapeCount();
+      const auto handles = transform_mirror.handles();
+
+      // Traversal: find the visible bodies, and build their vertices (or draw each one, if not batched)
+      {
+         BUF_PROFILE_SCOPE(frame_profiler.histogram(FrameProfiler::Phase::RenderTraversal));
+         BUF_PROFILE_ACCUMULATE(frame_stats.render_ticks);
+         BUF_TRACE_SCOPE("render_traversal");
 
+         const auto rows = findVisibleRows();
+         frame_stats.bodies_drawn += rows.size();
+         frame_stats.bodies_culled += transform_mirror.size() - rows.size();
 
-      while (body_node_ptr != nullptr)
-      {
-         auto shape_ptr = body_node_ptr->GetFixtureList()->GetShape();
-         auto poly_ptr = dynamic_cast<b2PolygonShape*>(shape_ptr);
-         assert(poly_ptr != nullptr);
+         for (const std::uint32_t body_index : rows)
+         {
+            // Draw the body between its previous and current transform, at the display time (render_alpha)
+            const b2Vec2 position{ previous_x[body_index] + render_alpha * (x[body_index] - previous_x[body_index]),
+                                   previous_y[body_index] + render_alpha * (y[body_index] - previous_y[body_index]) };
+            const float angle = previous_angles[body_index] + render_alpha * (angles[body_index] - previous_angles[body_index]);
+            const buf::Vec3 color = renderStyleColor(body_metadata[handles[body_index]].render_style);
+
+            for (const RenderShape& shape : shapes.subspan(first_shapes[body_index], shape_counts[body_index]))
+            {
+               switch (shape.kind)
+               {
+               case ShapeKind::Polygon:
+               {
+                  auto span_points{ makeVec2Span(shape.vertices, shape.vertex_count) };
+                  if (batched)
+                     batch_renderer.addPolygon(span_points, position, angle, color);
+                  else
+                     drawPoly(span_points, position, angle, color);
+                  break;
+               }
+               case ShapeKind::Circle:
+                  if (batched)
+                     batch_renderer.addCircle(shape.center, shape.radius, position, angle, color);
+                  else
+                     drawCircle(shape.center, shape.radius, position, angle, color);
+                  break;
+               }
+            }
+         }
+      }
 
-         auto span_points{ makeVec2Span(poly_ptr->m_vertices, poly_ptr->m_count) };
-         drawPoly(span_points, body_node_ptr->GetWorldCenter(), body_node_ptr->GetAngle());
+      if (batched)
+      {
+         BUF_PROFILE_SCOPE(frame_profiler.histogram(FrameProfiler::Phase::RenderSubmit));
+         BUF_PROFILE_ACCUMULATE(frame_stats.render_ticks);
+         BUF_TRACE_SCOPE("render_submit");
+         batch_renderer.submit();   // Draw every body with one draw call
+      }
 
-         body_node_ptr = body_node_ptr->GetNext(); // Get the next body in the world
+      if (hud_visible)
+      {
+         BUF_PROFILE_SCOPE(frame_profiler.histogram(FrameProfiler::Phase::Hud));
+         BUF_PROFILE_ACCUMULATE(frame_stats.render_ticks);
+         BUF_TRACE_SCOPE("hud");
+         hud.draw(window_width, window_height);   // Over the world, with one draw call
       }
 
-      glutSwapBuffers();   // Swap the hidden buffer with the old to show the new display buffer
+      {
+         BUF_PROFILE_SCOPE(frame_profiler.histogram(FrameProfiler::Phase::SwapBuffers));
+         BUF_TRACE_SCOPE("swap_buffers");
+         glutSwapBuffers();   // Swap the hidden buffer with the old to show the new display buffer
+      }
    }
 
    // Purpose: Initialize the Box2D world and create/place the static objects.
    void Engine::initBox2DWorld()
    {
-      // world = new b2World(b2Vec2(0.0f, 0.0f)); // 0, 0 to removed all gravity: Was (0.0f, 9.81f) for gravity
-      world = new b2World(b2Vec2(0.0f, -9.8f));
-
-      world->SetContactListener(&contact_listener);
+      // simulation.createWorld(b2Vec2(0.0f, 0.0f)); // 0, 0 to removed all gravity: Was (0.0f, 9.81f) for gravity
+      simulation.createWorld(b2Vec2(0.0f, -9.8f));
 
       // Add a static platform where boxes will land and stop.
       const auto& [world_x, world_y] = screenToWorldScaled(screen_width_default / 2, 50);
 
-      addRectToWorld(x_world_display_max_nominal / 2.0f, 0.8f, 10.0f, 0.4f, false /*not dynamic, so static*/);
+      simulation.addRect(x_world_display_max_nominal / 2.0f, 0.8f, 10.0f, 0.4f, false /*not dynamic, so static*/);
    }
 
    // Purpose: Sets up an orthographic view.  
@@ -325,50 +649,271 @@ namespace bolt::game_engine
       glOrtho(0.0, x_world_display_max, 0.0, y_world_display_max, 1.0, -1.0);
 
       glMatrixMode(GL_MODELVIEW); //set the matrix back to model
+
+      invalidate();
    }
 
    // Purpose: Update the position of objects/bodies in the world
+   //    Inputs due before this step are applied first, in the order they were queued, so the step they take effect on does not
+   //    depend on when (in the frame) they arrived.
    void Engine::update()
    {
-      world->Step(1.0f / ScreenFramesPerSecond /*amount of time that passed*/,
-         5 /*magic number*/, 5 /*magic number*/);  // I guess these numbers affect accuracy and overhead of collision detection and position calculations.
+      BUF_PROFILE_SCOPE(frame_profiler.histogram(FrameProfiler::Phase::Update));
+      BUF_PROFILE_ACCUMULATE(frame_stats.update_ticks);
+      BUF_TRACE_SCOPE("update");
+
+      InputEvent event;
+      while (input_queue.popDue(step_count, event))
+      {
+         if (!input_record_path.empty())
+         {
+            event.step = step_count;   // When it was applied (later than it was stamped if it arrived late)
+            input_log.record(event);
+         }
+         applyInput(event);
+      }
+
+      if (simulation.step() > 0)   // Bodies were destroyed, so they must disappear from the display
+         invalidate();
+      ++step_count;
+
+      // The contact callbacks run inside the step, so their time is added up over it
+      if constexpr (ProfilingEnabled)
+      {
+         const std::uint64_t contact_callback_ticks = simulation.getContactListener().getCallbackTicks();
+         frame_profiler.record(FrameProfiler::Phase::ContactCallbacks, contact_callback_ticks - last_contact_callback_ticks);
+         last_contact_callback_ticks = contact_callback_ticks;
+      }
+
+      if (deterministic)
+         state_hash = simulation.getTransformMirror().stateHash();
+   }
+
+   // Purpose: Apply an input (at a step boundary, from update())
+   void Engine::applyInput(const InputEvent& event)
+   {
+      switch (event.type)
+      {
+      case InputType::SpawnPrefab:
+         if (event.value < prefab_registry.size())
+            spawnPrefab(event.value, event.x, event.y);
+         break;
+      case InputType::SetDestroyOnContact:
+         setDestroyOnContact(event.value != 0);
+         std::cout << "Destroy bodies when they land " << (simulation.getDestroyOnContact() ? "on" : "off") << std::endl;
+         break;
+      case InputType::SaveWorld:
+         if (auto snapshot_result = saved_snapshot.capture(simulation); snapshot_result)
+            std::cout << std::format("World saved: {} bodies in {} bytes", simulation.getBodyCounts().live, saved_snapshot.size()) << std::endl;
+         else
+            std::cerr << "World not saved: " << snapshot_result.error() << std::endl;
+         break;
+      case InputType::RestoreWorld:
+      {
+         const WorldSnapshot& snapshot = saved_snapshot.empty() ? start_snapshot : saved_snapshot;
+         if (auto snapshot_result = snapshot.restore(simulation); snapshot_result)
+            std::cout << "World restored to the " << (saved_snapshot.empty() ? "starting scene" : "last save") << std::endl;
+         else
+            std::cerr << "World not restored: " << snapshot_result.error() << std::endl;
+         invalidate();
+         break;
+      }
+      }
+   }
+
+   // Purpose: Print the frame statistics gathered since the last report, then start gathering again
+   void Engine::reportFrameStats(LoopClock::time_point now)
+   {
+      const double cpu_seconds = processCpuSeconds();
+      const double elapsed_seconds = std::chrono::duration<double>(now - frame_stats.start_time).count();
+
+      if (report_frame_stats && elapsed_seconds > 0.0)
+      {
+         const BodyCounts body_counts = getBodyCounts();
+         std::cout << std::format("Frames: loops/sec {:.1f}  steps/sec {:.1f}  frames/sec {:.1f}  CPU {:.1f}%  bodies: live {} spawned {} despawned {}",
+            frame_stats.loop_count / elapsed_seconds, frame_stats.physics_steps / elapsed_seconds, frame_stats.frames_rendered / elapsed_seconds,
+            100.0 * (cpu_seconds - frame_stats.start_cpu_seconds) / elapsed_seconds, body_counts.live, body_counts.spawned, body_counts.despawned) << std::endl;
+
+         std::cout << simulation.iterationsReport() << std::endl;
+         if (deterministic)
+            std::cout << std::format("Deterministic: step {}  state hash {:016x}", step_count, state_hash) << std::endl;
+
+         if (frame_stats.frames_rendered > 0)
+         {
+            std::cout << std::format("Frames: bodies per frame: drawn {:.1f}  culled {:.1f}", 
+               static_cast<double>(frame_stats.bodies_drawn) / frame_stats.frames_rendered, static_cast<double>(frame_stats.bodies_culled) / frame_stats.frames_rendered) << std::endl;
+         }
+      }
+
+      if (frame_stats.loop_count > 0)   // Not when gathering starts
+         updateHud(elapsed_seconds);
+
+      frame_stats = FrameStats{};
+      frame_stats.start_time = now;
+      frame_stats.start_cpu_seconds = cpu_seconds;
+   }
+
+   // Purpose: Refresh the on-screen stats from the frame stats gathered over the elapsed time
+   //    The step and render times are averages over the physics steps and frames (zero if built with BOLT_DISABLE_PROFILING).
+   void Engine::updateHud(double elapsed_seconds)
+   {
+      const double step_ms = (frame_stats.physics_steps > 0) ? CycleClock::toMicroseconds(frame_stats.update_ticks) / (1000.0 * frame_stats.physics_steps) : 0.0;
+      const double render_ms = (frame_stats.frames_rendered > 0) ? CycleClock::toMicroseconds(frame_stats.render_ticks) / (1000.0 * frame_stats.frames_rendered) : 0.0;
+
+      const std::string text = std::format("FPS {:.1f}\nStep {:.2f} ms\nRender {:.2f} ms\nBodies {}\nAwake {}\nContacts {}",
+         frame_stats.frames_rendered / elapsed_seconds, step_ms, render_ms, getBodyCounts().live, simulation.awakeBodyCount(), simulation.getContactCount());
+      if (hud.setText(text) && hud_visible)
+         invalidate();   // Show the new stats, even if nothing else changed
    }
 
    // Purpose: Run the main render loop
+   //    Steps the physics by a fixed time step as many times as needed to catch up with the wall-clock time that has passed,
+   //    then (if anything changed) redraws with the bodies interpolated by the left over (not yet simulated) fraction of a step.
    void Engine::runMainLoop(int val)
    {
-      update();   // Update the position of objects/bodies in the world
+      if (stop_requested)
+      {
+         glutLeaveMainLoop();   // Ctrl-C: runEngine() shuts down once glutMainLoop() returns
+         return;
+      }
 
-      render();   // Render the next display/frame (and swap to the newly drawn frame)
+      BUF_TRACE_SCOPE("main_loop");
+      const auto now = LoopClock::now();
+      ++frame_stats.loop_count;
+      step_accumulator += std::chrono::duration<double>(now - last_loop_time).count();
+      last_loop_time = now;
+
+      std::int32_t steps = 0;
+      const float fixed_time_step = simulation.getTimeStep();
+      while (step_accumulator >= fixed_time_step && steps < max_steps_per_frame)
+      {
+         update();   // Update the position of objects/bodies in the world
+
+         step_accumulator -= fixed_time_step;
+         ++steps;
+      }
+      frame_stats.physics_steps += steps;
+
+      // Running too slow to catch up, so drop the (whole steps of) time we could not simulate rather than falling further behind
+      if (step_accumulator >= fixed_time_step)
+         step_accumulator = std::fmod(step_accumulator, static_cast<double>(fixed_time_step));
+
+      render_alpha = static_cast<float>(step_accumulator / fixed_time_step);
+
+      // Awake bodies are moving (and drawn interpolated between steps), so the display is out of date.  Once everything is 
+      // asleep the same frame would just be drawn again, so nothing is redrawn until something changes.
+      if (simulation.anyBodyAwake())
+         invalidate();
+
+      // Render the next display/frame (and swap to the newly drawn frame) via the glutDisplayFunc(), unless over the frame cap
+      const bool under_frame_cap = (max_frames_per_second <= 0.0f) || 
+         (std::chrono::duration<double>(now - last_render_time).count() >= 1.0 / max_frames_per_second);
+      if (redraw_needed && under_frame_cap)
+         glutPostRedisplay();
+
+      if (now - frame_stats.start_time >= std::chrono::seconds(1))
+      {
+         reportFrameStats(now);
+         checkpointInputRecording();
+      }
 
       // Setup a timer (in milliseconds), then call the runMainLoop() function again. 
       //  val - is just a user provided value so the user can (potentially) identify the reason a timer when off
-      glutTimerFunc(1000 / ScreenFramesPerSecond, runMainLoop, val); //Run frame one more time
+      glutTimerFunc(1000 / ScreenFramesPerSecond, timerCallback, val); //Run frame one more time
    }
 
-   // Purpose: Callback when a mouse event occurs (assuming it was registered with glutMouseFunc())
-   void Engine::mouseEventCallback(int button, int state, int screen_x, int screen_y)
+   // Purpose: Run the physics (only) as fast as possible with no graphics, reporting steps per second.
+   //    Note: No glut timer throttles the loop and no OpenGL calls are made, so this measures the physics hot path on its own.
+   void Engine::runHeadlessLoop()
    {
-      if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
+      using Clock = std::chrono::steady_clock;
+      using Seconds = std::chrono::duration<double>;
+
+      constexpr std::int64_t steps_per_clock_check = 64;   // Only read the clock occasionally, so timing does not skew the measurement
+      constexpr Seconds report_interval{ 1.0 };
+
+      const auto loop_start = Clock::now();
+      auto report_start = loop_start;
+      std::int64_t report_start_step = 0;
+      std::int64_t spawn_count = 0;
+      std::vector<b2Vec2> spawn_positions;
+
+      std::int64_t step = 0;
+      for (; (headless_step_limit <= 0 || step < headless_step_limit) && !stop_requested; ++step)
       {
-         const auto& [world_x, world_y] = screenToWorldScaled(screen_x, screen_y);
+         // Spawn triangles spread over the platform, like a player clicking above it
+         if (headless_spawn_interval_steps > 0 && step % headless_spawn_interval_steps == 0)
+         {
+            spawn_positions.clear();
+            for (std::int32_t batch_index = 0; batch_index < headless_spawn_batch; ++batch_index, ++spawn_count)
+            {
+               const float x_offset = static_cast<float>(spawn_count % 11 - 5) * 0.8f;
+               const float y_offset = static_cast<float>(batch_index / 11 % 10) * 0.3f;   // Stack batches of more than 11 in rows
+               spawn_positions.emplace_back(x_world_display_max_nominal / 2.0f + x_offset, y_world_display_max_nominal - 1.0f - y_offset);
+            }
+            spawnMany(triangle_prefab, spawn_positions);
+         }
+
+         update();   // Update the position of objects/bodies in the world
+
+         if ((step + 1) % steps_per_clock_check == 0)
+         {
+            const auto now = Clock::now();
+            const Seconds report_elapsed = now - report_start;
+            if (report_elapsed >= report_interval)
+            {
+               const double steps_per_second = (step + 1 - report_start_step) / report_elapsed.count();
+               const BodyCounts body_counts = getBodyCounts();
+               std::cout << std::format("Headless: step {}  bodies: live {} spawned {} despawned {} destroyed {}  steps/sec {:.1f}  contacts: begin {} impact {} dropped {}", 
+                  step + 1, body_counts.live, body_counts.spawned, body_counts.despawned, body_counts.destroyed, steps_per_second, 
+                  simulation.getContactCounts().begin, simulation.getContactCounts().impact, simulation.getContactListener().getOverflowCount()) << std::endl;
+               std::cout << simulation.iterationsReport() << std::endl;
+               if (deterministic)
+                  std::cout << std::format("Deterministic: step {}  state hash {:016x}", step_count, state_hash) << std::endl;
+
+               checkpointInputRecording();
+               report_start = now;
+               report_start_step = step + 1;
+            }
+         }
+      }
 
+      const Seconds total_elapsed = Clock::now() - loop_start;
+      const double steps_per_second = (total_elapsed.count() > 0.0) ? step / total_elapsed.count() : 0.0;
+      std::cout << std::format("Headless: finished {} steps in {:.3f} sec  bodies {}  steps/sec {:.1f}", step, total_elapsed.count(), simulation.getWorld()->GetBodyCount(), steps_per_second) << std::endl;
+      if (deterministic)
+         std::cout << std::format("Deterministic: step {}  state hash {:016x}", step_count, state_hash) << std::endl;
 
-         // Centroid calculator: https://eguruchela.com/math/calculator/polygon-centroid-point
-         const std::vector<buf::Vec2> standard_triangle
+      if (replaying)
+      {
+         const double simulated_seconds = step * static_cast<double>(simulation.getTimeStep());
+         std::cout << std::format("Replay: {:.1f} sec of play in {:.3f} sec ({:.1f}x real time)", simulated_seconds, total_elapsed.count(), 
+            (total_elapsed.count() > 0.0) ? simulated_seconds / total_elapsed.count() : 0.0) << std::endl;
+         if (replay_settings.state_hash != 0)
          {
+            if (state_hash == replay_settings.state_hash)
+               std::cout << "Replay: the final state matches the recording" << std::endl;
+            else
+               std::cout << std::format("Replay: the final state DIFFERS from the recording (state hash {:016x}, recorded {:016x})", state_hash, replay_settings.state_hash) << std::endl;
+         }
+      }
+   }
 
-// #define BAD_TRIANGLE         
-#ifdef BAD_TRIANGLE
-            {-0.1333 + 0.5, -0.0667}, {0.0667 + 0.5,-0.0667}, {0.0667 + 0.5,0.1333},  // Bad because points not arranged around centroid
-#else
-            {-0.1333, -0.0667}, {0.0667,-0.0667}, {0.0667,0.1333},
-#endif
-         };
+   // Purpose: Handle a mouse event (from mouseEventCallback())
+   void Engine::mouseEvent(int button, int state, int screen_x, int screen_y)
+   {
+      // Spawns are queued for the next step (not spawned in the middle of the frame)
+      if (button == GLUT_LEFT_BUTTON && state == GLUT_DOWN)
+      {
+         const auto& [world_x, world_y] = screenToWorldScaled(screen_x, screen_y);
 
-         // @@ TODO: JAB: Call function on (bad) triangle to orientToCentroid()
+         queueInput({ .step = step_count, .type = InputType::SpawnPrefab, .value = triangle_prefab, .x = world_x, .y = world_y });
+      }
+      else if (button == GLUT_RIGHT_BUTTON && state == GLUT_DOWN)
+      {
+         const auto& [world_x, world_y] = screenToWorldScaled(screen_x, screen_y);
 
-         addPolyToWorld(world_x, world_y, standard_triangle, true /*dynamic_object*/);
+         queueInput({ .step = step_count, .type = InputType::SpawnPrefab, .value = ball_prefab, .x = world_x, .y = world_y });
       }
 
       // Other callbacks include
@@ -379,8 +924,8 @@ namespace bolt::game_engine
       //glutMotionFunc(drag);// when the mouse drags around 
    }
 
-   // Purpose: Callback when a key is pressed
-   void Engine::keyboardEventCallback(unsigned char key, int where_mouse_is_x, int where_mouse_is_y)
+   // Purpose: Handle a key press (from keyboardEventCallback())
+   void Engine::keyboardEvent(unsigned char key, int where_mouse_is_x, int where_mouse_is_y)
    {
 #ifdef PRINT_WHERE_MOUSE_IS
       dbg(__func__); dbg(where_mouse_is_x); dbg(where_mouse_is_y); dbgln(key);   // Debug: Just print out the key
@@ -392,11 +937,84 @@ namespace bolt::game_engine
       dbg(__func__); dbg(mouse_x_from_bot_left); dbg(mouse_y_from_bot_left); dbgln(key);   // Debug: Just print out the key
 #endif
 
-      if (key == 27)
+      if (key == 'b')
+      {
+         setRenderPath((render_path == RenderPath::Batched) ? RenderPath::Immediate : RenderPath::Batched);
+         std::cout << "Render path: " << ((render_path == RenderPath::Batched) ? "batched" : "immediate") << std::endl;
+      }
+      else if (key == 'c')
+      {
+         setCulling(!culling);
+         std::cout << "Culling off screen bodies " << (culling ? "on" : "off") << std::endl;
+      }
+      else if (key == 'i')
+      {
+         if (deterministic)
+            std::cout << "Solver iterations are fixed in deterministic mode" << std::endl;
+         else
+         {
+            setAdaptiveIterations(!simulation.getAdaptiveIterations());
+            std::cout << simulation.iterationsReport() << std::endl;
+         }
+      }
+      // Keys that change the simulation are queued for the next step, like spawns
+      else if (key == 'k')
+         queueInput({ .step = step_count, .type = InputType::SetDestroyOnContact, .value = simulation.getDestroyOnContact() ? 0u : 1u });
+      else if (key == 's')
+         queueInput({ .step = step_count, .type = InputType::SaveWorld });
+      else if (key == 'r')
+         queueInput({ .step = step_count, .type = InputType::RestoreWorld });
+      else if (key == 'p')
+         frame_profiler.report(std::cout);   // Where the frame time has gone (since the start)
+      else if (key == 't')
+         toggleTraceRecording();             // When each phase ran, frame by frame (for a trace viewer)
+      else if (key == 'h')
       {
-         glutLeaveGameMode(); //set the resolution how it was
-         exit(0); //quit the program
+         setHudVisible(!hud_visible);
+         std::cout << "Stats overlay " << (hud_visible ? "on" : "off") << std::endl;
       }
+      else if (key == 'f')
+      {
+         report_frame_stats = !report_frame_stats;   // Toggle reporting frame stats once a second
+         std::cout << "Frame stats reporting " << (report_frame_stats ? "on" : "off") << std::endl;
+      }
+      else if (key == 27)
+         glutLeaveMainLoop();   // Quit: runEngine() shuts down (saving the input log, etc.) once glutMainLoop() returns
+   }
+
+   // Purpose: Callback to draw the display (registered with glutDisplayFunc())
+   void Engine::displayCallback()
+   {
+      if (glut_engine != nullptr)
+         glut_engine->render();
+   }
+
+   // Purpose: Callback when the window changes size (registered with glutReshapeFunc())
+   void Engine::reshapeCallback(int win_width, int win_height)
+   {
+      if (glut_engine != nullptr)
+         glut_engine->reshapeOrtho(win_width, win_height);
+   }
+
+   // Purpose: Callback when the main loop's timer goes off (registered with glutTimerFunc())
+   void Engine::timerCallback(int val)
+   {
+      if (glut_engine != nullptr)
+         glut_engine->runMainLoop(val);
+   }
+
+   // Purpose: Callback when a mouse event occurs (assuming it was registered with glutMouseFunc())
+   void Engine::mouseEventCallback(int button, int state, int screen_x, int screen_y)
+   {
+      if (glut_engine != nullptr)
+         glut_engine->mouseEvent(button, state, screen_x, screen_y);
+   }
+
+   // Purpose: Callback when a key is pressed
+   void Engine::keyboardEventCallback(unsigned char key, int where_mouse_is_x, int where_mouse_is_y)
+   {
+      if (glut_engine != nullptr)
+         glut_engine->keyboardEvent(key, where_mouse_is_x, where_mouse_is_y);
    }
 
 } // End namespace bolt::engine
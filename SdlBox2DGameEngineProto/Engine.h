@@ -1,14 +1,26 @@
 #pragma once
 // Purpose: The 2D game engine.  
 //    pwb 11/25/2021
-//    NOTE: This class consists of only static functions because (OpenGL) Glut libraries/framework 
-//          does not support callbacks to objects (callbacks must be registered as static member or free functions).
+//    NOTE: (OpenGL) Glut libraries/framework does not support callbacks to objects (callbacks must be registered as static 
+//          member or free functions), so the callbacks are static functions that forward to the engine that owns the window.  
+//          Glut has only one window per process, but any number of headless engines can run side by side.
 //
 
 #include "bolt_buf.h"
-#include "ContactListener.h"
+#include "BatchRenderer.h"
+#include "BodyMetadata.h"
+#include "FrameProfiler.h"
+#include "HudOverlay.h"
+#include "InputLog.h"
+#include "InputQueue.h"
+#include "PrefabRegistry.h"
+#include "Simulation.h"
+#include "WorldSnapshot.h"
 #include <tuple>
 #include <span>
+#include <chrono>
+#include <vector>
+#include <string>
 
 #include <Box2D/Box2D.h>
 
@@ -17,92 +29,269 @@ namespace bolt::game_engine
    class Engine
    {
    public:
-      enum class ScreenMode { None, FullScreen, NonFullScreen };
+      // Headless runs the physics world with no window and no OpenGL calls (e.g. for soak/load testing)
+      enum class ScreenMode { None, FullScreen, NonFullScreen, Headless };
+      // Batched draws every body with one OpenGL draw call per frame.  Immediate draws each body with its own glBegin()/glEnd().
+      enum class RenderPath { Immediate, Batched };
+
+      Engine() = default;
+      ~Engine();
+      // The simulation's world and the glut callbacks point into the engine, so an engine stays where it was made
+      Engine(const Engine&) = delete;
+      Engine& operator=(const Engine&) = delete;
 
       // Configure the engine before starting it
-      static buf::Result<void> configureEngine(ScreenMode screen_mode = ScreenMode::NonFullScreen);
+      buf::Result<void> configureEngine(ScreenMode screen_mode = ScreenMode::NonFullScreen);
+      // Set the options used when running with ScreenMode::Headless. 
+      //    step_limit: Number of physics steps to run before returning from runEngine().  Zero or less runs forever.
+      //    spawn_interval_steps: Spawn falling triangles every N steps (like a mouse click would).  Zero or less spawns nothing.
+      //    spawn_batch: Number of triangles spawned each time (with one spawnMany() call)
+      void setHeadlessOptions(std::int64_t step_limit, std::int32_t spawn_interval_steps, std::int32_t spawn_batch = 1) 
+         { headless_step_limit = step_limit; headless_spawn_interval_steps = spawn_interval_steps; headless_spawn_batch = spawn_batch; };
+      // Set the fixed rate the physics is stepped at (independent of the display rate), and the maximum number of 
+      // physics steps taken per displayed frame to catch up with the wall-clock (any time beyond that is dropped).  Returns an
+      // error (and changes nothing) unless both are above zero.
+      buf::Result<void> setPhysicsRate(float steps_per_second, std::int32_t max_steps_per_frame);
+      // Choose the solver iterations each step from how long the steps take (can be toggled with the 'i' key), rather than 
+      // always using VelocityIterations and PositionIterations (the default, so runs are repeatable).  Ignored in deterministic mode.
+      void setAdaptiveIterations(bool _adaptive_iterations) { simulation.setAdaptiveIterations(_adaptive_iterations && !deterministic); };
+      // Run in deterministic (lockstep) mode: the solver iterations are fixed (never chosen from how long the steps take), and
+      // every body's state is hashed after each step (see getStateHash()), so runs given the same inputs can be checked to 
+      // stay identical, step by step.  Player inputs are always applied at step boundaries (see queueInput()).
+      void setDeterministic(bool _deterministic);
+      // Queue an input to be applied before its step (e.g. an input made on another machine, stamped with the step it was made on)
+      void queueInput(const InputEvent& event) { input_queue.push(event); };
+      // Get the number of physics steps taken since the world was configured (or reset).  Inputs made now are applied before this step.
+      std::int64_t getStepCount() const { return step_count; };
+      // Get the hash of every body's position, angle and velocity after the last step (deterministic mode only, otherwise zero)
+      std::uint64_t getStateHash() const { return state_hash; };
+      // Record every input applied (stamped with its step), and the run's settings, to a binary log file written when the run
+      // ends (set before runEngine())
+      void setInputRecording(const std::string& path) { input_record_path = path; };
+      // Replay the inputs recorded in a log file (set before runEngine(), with ScreenMode::Headless).  The run is played out 
+      // again with the recorded settings, as fast as the physics can go, then the time taken is reported (and, if it was 
+      // recorded in deterministic mode, whether it ended in the same state).  Returns an error if the log cannot be read.
+      buf::Result<void> setInputReplay(const std::string& path);
+      // Set the Chrome trace file the 't' key records the engine's timeline to (default "trace.json").  If start is true,
+      // recording starts with the run (set before runEngine()).  The trace is written when recording stops, or the run ends.
+      void setTraceRecording(const std::string& path, bool start) { trace_path = path; trace_on_start = start; };
+      // Set how often the display may be redrawn (set before configureEngine()).  The display is only redrawn when something
+      // changed, at most max_frames_per_second times a second (zero for no cap), optionally waiting for vertical sync on swap.
+      void setFramePolicy(float _max_frames_per_second, bool _vsync) { max_frames_per_second = _max_frames_per_second; vsync = _vsync; };
+      // Request the display be redrawn (at the next opportunity allowed by the frame policy)
+      void invalidate() { redraw_needed = true; };
+      // Counts of the bodies in the world, for watching its population over a long session
+      using BodyCounts = Simulation::BodyCounts;
+
+      // Choose how bodies are drawn (can be toggled with the 'b' key while running)
+      void setRenderPath(RenderPath _render_path) { render_path = _render_path; invalidate(); };
+      // Only draw the bodies in the visible rectangle of the world, found with the Box2D broadphase (can be toggled with the 'c' key)
+      void setCulling(bool _culling) { culling = _culling; invalidate(); };
+      // Show (or hide) the on-screen stats overlay: frames per second, step and render time, and body and contact counts
+      void setHudVisible(bool _hud_visible) { hud_visible = _hud_visible; invalidate(); };
+      // Mark a body to be destroyed after the current physics step (safe to call at any time, including from Box2D callbacks)
+      void markForDestruction(b2Body* body) { simulation.markForDestruction(body); };
+      // Destroy dynamic bodies as soon as they touch a static body (can be toggled with the 'k' key while running)
+      void setDestroyOnContact(bool _destroy_on_contact) { simulation.setDestroyOnContact(_destroy_on_contact); };
+      // Destroy bodies spawned from prefabs this many seconds (of simulated time) after they spawn (BodyMetadata::Forever to keep them)
+      void setSpawnLifetime(float seconds) { simulation.setSpawnLifetime(seconds); };
+      // Set the kill volume (world coordinates).  Dynamic bodies whose position leaves it are destroyed, so bodies that miss the 
+      // platform and fall forever are not stepped and drawn forever.  Defaults to the nominal display with a display sized margin.
+      void setKillVolume(const b2AABB& _kill_volume) { simulation.setKillVolume(_kill_volume); };
+      // Get the counts of the bodies in the world
+      BodyCounts getBodyCounts() const { return simulation.getBodyCounts(); };
+      // Get the prefabs bodies can be spawned from (add more with its addPolygon() and addCircle())
+      PrefabRegistry& getPrefabRegistry() { return prefab_registry; };
+      const PrefabRegistry& getPrefabRegistry() const { return prefab_registry; };
+      // Get the prefab of the standard (dynamic) triangle
+      PrefabHandle getTrianglePrefab() const { return triangle_prefab; };
+      // Spawn a body from a prefab at the world coordinates.  Returns the new body.
+      b2Body* spawnPrefab(PrefabHandle prefab, float x_world, float y_world);
+      // Spawn a body from the prefab at each world position.  Returns the number of bodies spawned.
+      std::size_t spawnMany(PrefabHandle prefab, std::span<const b2Vec2> positions);
+      // Get the gameplay data of every body (a body's handle is BodyMetadataTable::handleOf(body))
+      const BodyMetadataTable& getBodyMetadata() const { return simulation.getBodyMetadata(); };
+      // Get the contiguous copy of every body's transform, refreshed after each physics step (for streaming through all bodies)
+      const TransformMirror& getTransformMirror() const { return simulation.getTransformMirror(); };
       // Start running the game engine 
-      static buf::Result<void> runEngine();
+      buf::Result<void> runEngine();
+      // Put the world back to the starting scene (restored from a snapshot of it), without reconfiguring the graphics 
+      // (e.g. between runs)
+      void resetWorld();
       // Get the result of configuration
-      static buf::Result<void> getConfigureResult() { return config_result; };
+      buf::Result<void> getConfigureResult() const { return config_result; };
       // Return the nominal upper and lower world coordinates displayed on screen in meters. The term 
       // nominal means the (default) display area for which the engine was designed to show the player. This 
       // may vary from what is actually being displayed. Returned as <x_min, y_min, x_max, y_max>
       static std::tuple<float, float, float, float> getWorldDisplayedInMetersNominal() { return { 0.0f, 0.0f, x_world_display_max_nominal, y_world_display_max_nominal }; };
 
    private:
-      static ScreenMode screen_mode;   // Full screen mode or not
+      ScreenMode screen_mode{ ScreenMode::None };   // Full screen mode or not
+
+      std::int64_t headless_step_limit{ 0 };            // Steps to run in headless mode (zero or less runs forever)
+      std::int32_t headless_spawn_interval_steps{ 30 };    // Spawn triangles every N steps in headless mode (zero or less for none)
+      std::int32_t headless_spawn_batch{ 1 };             // Triangles spawned each time in headless mode
 
       static constexpr int ScreenFramesPerSecond = 60;
 
+      //// Inputs are applied at step boundaries, so a run can be repeated (and, in deterministic mode, checked step by step)
+      InputQueue input_queue{};                 // Inputs waiting for their step
+      std::int64_t step_count{ 0 };             // Physics steps taken (inputs made now are stamped with this step)
+      bool deterministic{ false };              // Fixed solver iterations, and the state hashed after every step
+      std::uint64_t state_hash{ 0 };            // Hash of every body's state after the last step (deterministic mode only)
+
+      std::string input_record_path{};          // Where to write the input log (empty if not recording)
+      InputLog input_log{};                     // Inputs applied during this run (recording), or the run being replayed
+      InputLog::RunSettings record_settings{};  // Settings at the start of the recorded run
+      bool replaying{ false };                  // Replaying an input log (headless)
+      InputLog::RunSettings replay_settings{};  // Settings of the run being replayed
+
+      //// Fixed time step: the physics always steps by the simulation's time step, as many times as needed to keep up with the wall-clock.
+      using LoopClock = std::chrono::steady_clock;   // Monotonic clock for measuring frame time
+
+      std::int32_t max_steps_per_frame{ 5 };        // Cap on physics steps per frame (avoids the "spiral of death" when running slow)
+      LoopClock::time_point last_loop_time{};    // When runMainLoop() last ran
+      double step_accumulator{ 0.0 };                 // Wall-clock seconds not yet simulated (always less than a time step after a frame)
+      float render_alpha{ 1.0f };                      // How far (0 to 1) the display is between the previous and current physics step
+
+      //// Render on demand: the display is only redrawn after the physics moved something, a reshape, or invalidate()
+      bool redraw_needed{ true };                      // Something changed since the display was last drawn
+      float max_frames_per_second{ 0.0f };             // Cap on display redraws per second (zero for no cap)
+      bool vsync{ false };                              // Wait for vertical sync when swapping display buffers
+      LoopClock::time_point last_render_time{};  // When render() last drew the display
+
+      // Frame statistics, reported once a second when enabled (toggle with the 'f' key) to see how busy the loop is
+      struct FrameStats
+      {
+         std::int64_t loop_count = 0;        // Times runMainLoop() ran
+         std::int64_t physics_steps = 0;     // Physics steps taken
+         std::int64_t frames_rendered = 0;   // Times the display was drawn
+         std::int64_t bodies_drawn = 0;      // Bodies drawn, summed over every frame rendered
+         std::int64_t bodies_culled = 0;     // Bodies not drawn because they were off screen, summed over every frame rendered
+         std::uint64_t update_ticks = 0;     // CycleClock ticks spent in update() (the physics steps)
+         std::uint64_t render_ticks = 0;     // CycleClock ticks spent drawing (not including swapping the display buffers)
+         LoopClock::time_point start_time{};
+         double start_cpu_seconds = 0.0;     // Process CPU time at start_time
+      };
+      FrameStats frame_stats{};
+      bool report_frame_stats{ false };
+
+      FrameProfiler frame_profiler{};                   // Time of each phase of the frame (printed with the 'p' key, and on exit)
+      std::uint64_t last_contact_callback_ticks{ 0 };   // The contact listener's callback ticks before the last step
+      std::string trace_path{ "trace.json" };           // Where the engine's timeline is recorded (toggled with the 't' key)
+      bool trace_on_start{ false };                     // Start recording the timeline with the run
+
+      RenderPath render_path{ RenderPath::Batched };            // How bodies are drawn
+      BatchRenderer batch_renderer{};      // Builds the frame's vertex array for RenderPath::Batched
+      bool culling{ true };                                 // Only draw the bodies in the visible rectangle
+      std::vector<std::uint32_t> visible_rows{};      // Transform mirror rows of the bodies to draw this frame
+      HudOverlay hud{};                               // On-screen stats, refreshed with the frame stats (once a second)
+      bool hud_visible{ true };
+
+      PrefabRegistry prefab_registry{};           // Templates for the bodies spawned during play
+      PrefabHandle triangle_prefab{ 0 };             // The standard (dynamic) triangle
+      PrefabHandle ball_prefab{ 0 };                 // The standard (dynamic) ball
+
       static constexpr float pixels_per_meter_nominal = 100.0f;	                  // Pixels per meter 
       static constexpr float meters_per_pixel_nominal = 1.0f / pixels_per_meter_nominal;   // Meters per pixel
 
       static constexpr std::int16_t screen_width_default = 1280;    // In pixels
       static constexpr std::int16_t screen_height_default = 1024;    // In pixels
 
-      static std::int16_t window_width;   // Current window in pixels
-      static std::int16_t window_height;  // Current window in pixels
+      std::int16_t window_width{ screen_width_default };   // Current window in pixels
+      std::int16_t window_height{ screen_height_default };  // Current window in pixels
 
       static constexpr float x_world_display_max_nominal = meters_per_pixel_nominal * screen_width_default;
       static constexpr float y_world_display_max_nominal = meters_per_pixel_nominal * screen_height_default;
 
       // Show less of the world as the window gets smaller ...
-      static float x_world_display_max;
-      static float y_world_display_max;
+      float x_world_display_max{ x_world_display_max_nominal };
+      float y_world_display_max{ y_world_display_max_nominal };
 
       // Return number of meters in physicals world, given pixels
       static float pixelsToMetersNominal(std::int16_t pixels) { return meters_per_pixel_nominal * pixels; }
 
       // Convert screen coordinates (top-left) to world coordinates (bottom-left and scaled).
       static float screenToWorldScaledX(std::int16_t x_screen) { return pixelsToMetersNominal(x_screen); }
-      static float screenToWorldScaledY(std::int16_t y_screen) { return pixelsToMetersNominal(window_height - y_screen); };
+      float screenToWorldScaledY(std::int16_t y_screen) { return pixelsToMetersNominal(window_height - y_screen); };
 
-      static std::pair<float, float> screenToWorldScaled(std::int16_t x_screen, std::int16_t y_screen) { return { screenToWorldScaledX(x_screen), screenToWorldScaledY(y_screen) }; };
+      std::pair<float, float> screenToWorldScaled(std::int16_t x_screen, std::int16_t y_screen) { return { screenToWorldScaledX(x_screen), screenToWorldScaledY(y_screen) }; };
 
       // Unscaled - Convert screen coordinates (top-left) to world coordinates (bottom-left and NON-scaled).
-      static std::pair<std::int16_t, std::int16_t> screenToWorldUnscaled(std::int16_t  x_screen, std::int16_t y_screen) { return { x_screen, window_height - y_screen }; };
+      std::pair<std::int16_t, std::int16_t> screenToWorldUnscaled(std::int16_t  x_screen, std::int16_t y_screen) { return { x_screen, window_height - y_screen }; };
 
       // Configure the graphics 
-      static buf::Result<void> configureGraphics(ScreenMode screen_mode);
+      buf::Result<void> configureGraphics(ScreenMode screen_mode);
+      // Ask the driver to wait for vertical sync when swapping buffers (if the platform supports it)
+      static void enableVSync();
 
-      // Add a new polygon to the (Box2D) world of object.
-      static b2Body* addPolyToWorld(float x_center_world, float y_center_world, const std::vector<buf::Vec2>& verts, bool dynamic_object);
-      // Add a new rectangle to the (Box2D) world of object.
-      static b2Body* addRectToWorld(float x, float y, float width, float height, bool dynamic_object);
+      // Return the color bodies with the render style are drawn in
+      static buf::Vec3 renderStyleColor(RenderStyle render_style);
+      // Add the standard prefabs (the triangle and ball spawned during play)
+      buf::Result<void> initPrefabs();
       // Draw a polygon
-      static void drawPoly(const std::span<buf::Vec2>& points, b2Vec2 center, float angle);
+      static void drawPoly(std::span<const buf::Vec2> points, b2Vec2 center, float angle, buf::Vec3 color);
+      // Draw a circle (as a fan of triangles).  The circle's center is given in body coordinates.
+      static void drawCircle(b2Vec2 circle_center, float radius, b2Vec2 center, float angle, buf::Vec3 color);
       // Draw a square. Assumes 4 vertex points using OpenGl
       static void drawSquare(b2Vec2* points, b2Vec2 center, float angle);
+      // Return the transform mirror rows (in order) of the bodies to draw: the ones in the visible rectangle if culling, else all of them
+      std::span<const std::uint32_t> findVisibleRows();
       // Render the graphics to hidden display buffer, and then swap buffers to show the new display
-      static void render();
+      void render();
       // Initialize the Box2D world and create/place the static objects.
-      static void initBox2DWorld();
+      void initBox2DWorld();
       // Sets up an orthographic view.  
-      static void reshapeOrtho(int w, int h);
+      void reshapeOrtho(int w, int h);
       // Update the position of objects/bodies in the world
-      static void update();
+      void update();
+      // Apply an input (at a step boundary, from update())
+      void applyInput(const InputEvent& event);
+      // Write the input log of the run so far (if recording), replacing the last one written, and keep recording
+      void checkpointInputRecording();
+      // Write the input log of the run (if recording), once, when the run ends
+      void saveInputRecording();
+      // Start recording the engine's timeline to the trace file, or stop and report how much was recorded
+      void toggleTraceRecording();
+      // Refresh the on-screen stats from the frame stats gathered over the elapsed time
+      void updateHud(double elapsed_seconds);
+      // Print the frame statistics gathered since the last report, then start gathering again
+      void reportFrameStats(LoopClock::time_point now);
       // Run the main render loop
-      static void runMainLoop(int val);
+      void runMainLoop(int val);
+      // Run the physics (only) as fast as possible with no graphics, reporting steps per second
+      void runHeadlessLoop();
+
+      // Handle a mouse event (from mouseEventCallback())
+      void mouseEvent(int button, int state, int screen_x, int screen_y);
+      // Handle a key press (from keyboardEventCallback())
+      void keyboardEvent(unsigned char key, int where_mouse_is_x, int where_mouse_is_y);
 
       ///////// Callbacks /////
+      //    Glut calls these (static) functions, which forward to the engine that owns the window
+      static Engine* glut_engine;   // The engine that configured the (one) glut window, or null
+
+      // Callback to draw the display (registered with glutDisplayFunc())
+      static void displayCallback();
+      // Callback when the window changes size (registered with glutReshapeFunc())
+      static void reshapeCallback(int win_width, int win_height);
+      // Callback when the main loop's timer goes off (registered with glutTimerFunc())
+      static void timerCallback(int val);
       // Callback when a mouse event occurs (assuming it was registered with glutMouseFunc())
       static void mouseEventCallback(int button, int state, int screen_x, int screen_y);
       // Callback when a key is pressed
       static void keyboardEventCallback(unsigned char key, int where_mouse_is_x, int where_mouse_is_y);
 
-      // @@@ TODO: Fix StaticType and DynamicType 
-      // #1 The tutorial used void pointers to "user data" with user data being int's.  So we need a couple ints to point to, where
-      //    the value of the int indicates our custom type - i.e. it is either a "static" box (the platform where boxes land),
-      //    or it is a "dynamic" box that we may want to delete.
-      // static const int StaticType = 0;     // We make either static boxes
-      // static const int DynamicType = 1;    // or dynamic boxes
+      // The Box2D world of objects, with its contact listener and the tables of its bodies.  
+      //    Kill volume: the nominal display with a display sized margin on every side.
+      Simulation simulation{ b2AABB{ b2Vec2(-x_world_display_max_nominal, -y_world_display_max_nominal),
+                                     b2Vec2(2.0f * x_world_display_max_nominal, 2.0f * y_world_display_max_nominal) } };
 
-      static ContactListener contact_listener;   // #1 Only need ONE instance of the contact listener to receive all collision callbacks
-      static b2World* world;                     // The Box2D world of objects
+      WorldSnapshot start_snapshot;   // The starting scene, for resetWorld()
+      WorldSnapshot saved_snapshot;   // Saved with the 's' key, and restored with the 'r' key
 
       // Record the results of a configuration attempt. Contains an error string if not (successfully) configured.
-      static buf::Result<void> config_result;
+      buf::Result<void> config_result{ buf::unexpected(std::string("There was no attempt to configure the engine.")) };
    };
 } // End namespace bolt::engine
 
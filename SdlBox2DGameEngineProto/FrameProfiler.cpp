@@ -0,0 +1,49 @@
+
+#include "FrameProfiler.h"
+
+#include <format>
+
+namespace bolt::game_engine
+{
+   // Purpose: Print the count, p50, p99, max and mean time of every phase (in microseconds)
+   void FrameProfiler::report(std::ostream& out) const
+   {
+      if (!buf::ProfilingEnabled)
+      {
+         out << "Profile: not recorded (built with BOLT_DISABLE_PROFILING defined)" << std::endl;
+         return;
+      }
+
+      out << std::format("Profile (microseconds): {:>18} {:>10} {:>10} {:>10} {:>10} {:>10}", "phase", "count", "p50", "p99", "max", "mean") << std::endl;
+      for (std::size_t phase_index = 0; phase_index < histograms.size(); ++phase_index)
+      {
+         const buf::Histogram& phase_histogram = histograms[phase_index];
+         out << std::format("Profile (microseconds): {:>18} {:>10} {:>10.2f} {:>10.2f} {:>10.2f} {:>10.2f}", phaseName(static_cast<Phase>(phase_index)), 
+            phase_histogram.count(), buf::CycleClock::toMicroseconds(phase_histogram.percentile(0.5)), buf::CycleClock::toMicroseconds(phase_histogram.percentile(0.99)), 
+            buf::CycleClock::toMicroseconds(phase_histogram.maxValue()), buf::CycleClock::toMicroseconds(1) * phase_histogram.mean()) << std::endl;
+      }
+   }
+
+   // Purpose: Forget every recorded time
+   void FrameProfiler::reset()
+   {
+      for (buf::Histogram& phase_histogram : histograms)
+         phase_histogram.reset();
+   }
+
+   // Purpose: Return the name of the phase
+   const char* FrameProfiler::phaseName(Phase phase)
+   {
+      switch (phase)
+      {
+      case Phase::Update:            return "update";
+      case Phase::ContactCallbacks:  return "contact_callbacks";
+      case Phase::RenderTraversal:   return "render_traversal";
+      case Phase::RenderSubmit:      return "render_submit";
+      case Phase::Hud:               return "hud";
+      case Phase::SwapBuffers:       return "swap_buffers";
+      case Phase::Count:             break;
+      }
+      return "unknown";
+   }
+} // End namespace bolt::game_engine
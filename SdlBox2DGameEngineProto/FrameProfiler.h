@@ -0,0 +1,48 @@
+#pragma once
+// Purpose: Where a frame's time goes.  Timed scopes (BUF_PROFILE_SCOPE) around each phase of the frame record its time in the 
+//          phase's histogram, and report() prints the p50, p99 and max of every phase.  Built with BOLT_DISABLE_PROFILING 
+//          defined, the scopes are removed and nothing is recorded.
+//
+
+#include "bolt_buf_profile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace bolt::game_engine
+{
+   class FrameProfiler
+   {
+   public:
+      // The phases timed
+      enum class Phase
+      {
+         Update,             // One physics step (Engine::update()), with its inputs and contact handling
+         ContactCallbacks,   // The contact listener's callbacks during one physics step (added up over the step)
+         RenderTraversal,    // Walking the visible bodies and building the frame's vertices (or drawing each body, if not batched)
+         RenderSubmit,       // Handing the batched vertices to OpenGL
+         Hud,                // Drawing the on-screen stats overlay
+         SwapBuffers,        // glutSwapBuffers() (includes waiting for vertical sync, if on)
+         Count
+      };
+
+      FrameProfiler() : histograms(static_cast<std::size_t>(Phase::Count)) {};
+
+      // Get the histogram of the phase's times (in CycleClock ticks), e.g. for BUF_PROFILE_SCOPE
+      buf::Histogram& histogram(Phase phase) { return histograms[static_cast<std::size_t>(phase)]; };
+      // Record a time (in CycleClock ticks) for the phase, e.g. a total added up with BUF_PROFILE_ACCUMULATE
+      void record(Phase phase, std::uint64_t ticks) { histogram(phase).record(ticks); };
+      // Print the count, p50, p99, max and mean time of every phase (in microseconds)
+      void report(std::ostream& out) const;
+      // Forget every recorded time
+      void reset();
+
+      // Return the name of the phase
+      static const char* phaseName(Phase phase);
+
+   private:
+      std::vector<buf::Histogram> histograms;   // One per phase (on the heap, as each is several kilobytes)
+   };
+} // End namespace bolt::game_engine
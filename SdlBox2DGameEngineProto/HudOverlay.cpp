@@ -0,0 +1,252 @@
+
+#include "HudOverlay.h"
+
+#include <GL/freeglut.h>
+#include <GL/gl.h>
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+
+namespace bolt::game_engine
+{
+   namespace
+   {
+      constexpr int AtlasWidth = HudOverlay::AtlasColumns * HudOverlay::CellSize;
+      constexpr int AtlasHeight = HudOverlay::AtlasRows * HudOverlay::CellSize;
+
+      //// The built in font: ' ' to 'Z' in ASCII order, 5x7 pixels.  Each glyph is 5 columns (left to right), and bit n of a
+      //   column is row n (from the top).
+      constexpr char FirstGlyph = ' ';
+      constexpr char LastGlyph = 'Z';
+      constexpr std::array<std::array<std::uint8_t, HudOverlay::GlyphWidth>, LastGlyph - FirstGlyph + 1> Font
+      { {
+         { 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+         { 0x00, 0x00, 0x5F, 0x00, 0x00 },   // '!'
+         { 0x00, 0x07, 0x00, 0x07, 0x00 },   // '"'
+         { 0x14, 0x7F, 0x14, 0x7F, 0x14 },   // '#'
+         { 0x24, 0x2A, 0x7F, 0x2A, 0x12 },   // '$'
+         { 0x23, 0x13, 0x08, 0x64, 0x62 },   // '%'
+         { 0x36, 0x49, 0x55, 0x22, 0x50 },   // '&'
+         { 0x00, 0x05, 0x03, 0x00, 0x00 },   // '''
+         { 0x00, 0x1C, 0x22, 0x41, 0x00 },   // '('
+         { 0x00, 0x41, 0x22, 0x1C, 0x00 },   // ')'
+         { 0x08, 0x2A, 0x1C, 0x2A, 0x08 },   // '*'
+         { 0x08, 0x08, 0x3E, 0x08, 0x08 },   // '+'
+         { 0x00, 0x50, 0x30, 0x00, 0x00 },   // ','
+         { 0x08, 0x08, 0x08, 0x08, 0x08 },   // '-'
+         { 0x00, 0x60, 0x60, 0x00, 0x00 },   // '.'
+         { 0x20, 0x10, 0x08, 0x04, 0x02 },   // '/'
+         { 0x3E, 0x51, 0x49, 0x45, 0x3E },   // '0'
+         { 0x00, 0x42, 0x7F, 0x40, 0x00 },   // '1'
+         { 0x42, 0x61, 0x51, 0x49, 0x46 },   // '2'
+         { 0x21, 0x41, 0x45, 0x4B, 0x31 },   // '3'
+         { 0x18, 0x14, 0x12, 0x7F, 0x10 },   // '4'
+         { 0x27, 0x45, 0x45, 0x45, 0x39 },   // '5'
+         { 0x3C, 0x4A, 0x49, 0x49, 0x30 },   // '6'
+         { 0x01, 0x71, 0x09, 0x05, 0x03 },   // '7'
+         { 0x36, 0x49, 0x49, 0x49, 0x36 },   // '8'
+         { 0x06, 0x49, 0x49, 0x29, 0x1E },   // '9'
+         { 0x00, 0x36, 0x36, 0x00, 0x00 },   // ':'
+         { 0x00, 0x56, 0x36, 0x00, 0x00 },   // ';'
+         { 0x08, 0x14, 0x22, 0x41, 0x00 },   // '<'
+         { 0x14, 0x14, 0x14, 0x14, 0x14 },   // '='
+         { 0x00, 0x41, 0x22, 0x14, 0x08 },   // '>'
+         { 0x02, 0x01, 0x51, 0x09, 0x06 },   // '?'
+         { 0x32, 0x49, 0x79, 0x41, 0x3E },   // '@'
+         { 0x7E, 0x11, 0x11, 0x11, 0x7E },   // 'A'
+         { 0x7F, 0x49, 0x49, 0x49, 0x36 },   // 'B'
+         { 0x3E, 0x41, 0x41, 0x41, 0x22 },   // 'C'
+         { 0x7F, 0x41, 0x41, 0x22, 0x1C },   // 'D'
+         { 0x7F, 0x49, 0x49, 0x49, 0x41 },   // 'E'
+         { 0x7F, 0x09, 0x09, 0x01, 0x01 },   // 'F'
+         { 0x3E, 0x41, 0x41, 0x51, 0x32 },   // 'G'
+         { 0x7F, 0x08, 0x08, 0x08, 0x7F },   // 'H'
+         { 0x00, 0x41, 0x7F, 0x41, 0x00 },   // 'I'
+         { 0x20, 0x40, 0x41, 0x3F, 0x01 },   // 'J'
+         { 0x7F, 0x08, 0x14, 0x22, 0x41 },   // 'K'
+         { 0x7F, 0x40, 0x40, 0x40, 0x40 },   // 'L'
+         { 0x7F, 0x02, 0x04, 0x02, 0x7F },   // 'M'
+         { 0x7F, 0x04, 0x08, 0x10, 0x7F },   // 'N'
+         { 0x3E, 0x41, 0x41, 0x41, 0x3E },   // 'O'
+         { 0x7F, 0x09, 0x09, 0x09, 0x06 },   // 'P'
+         { 0x3E, 0x41, 0x51, 0x21, 0x5E },   // 'Q'
+         { 0x7F, 0x09, 0x19, 0x29, 0x46 },   // 'R'
+         { 0x46, 0x49, 0x49, 0x49, 0x31 },   // 'S'
+         { 0x01, 0x01, 0x7F, 0x01, 0x01 },   // 'T'
+         { 0x3F, 0x40, 0x40, 0x40, 0x3F },   // 'U'
+         { 0x1F, 0x20, 0x40, 0x20, 0x1F },   // 'V'
+         { 0x7F, 0x20, 0x18, 0x20, 0x7F },   // 'W'
+         { 0x63, 0x14, 0x08, 0x14, 0x63 },   // 'X'
+         { 0x03, 0x04, 0x78, 0x04, 0x03 },   // 'Y'
+         { 0x61, 0x51, 0x49, 0x45, 0x43 },   // 'Z'
+      } };
+
+      constexpr int SolidCell = HudOverlay::AtlasColumns * HudOverlay::AtlasRows - 1;   // The last cell is solid (for the panel)
+      static_assert (Font.size() <= SolidCell);
+
+      //// Layout, in screen pixels
+      constexpr int Advance = (HudOverlay::GlyphWidth + 1) * HudOverlay::PixelScale;       // From one glyph to the next
+      constexpr int LineHeight = (HudOverlay::GlyphHeight + 3) * HudOverlay::PixelScale;   // From one line to the next
+      constexpr int Margin = 4 * HudOverlay::PixelScale;    // From the window's corner to the panel
+      constexpr int Padding = 3 * HudOverlay::PixelScale;   // From the panel's edge to the text
+
+      const buf::Vec4 TextColor{ 0.85f, 1.0f, 0.85f, 1.0f };
+      const buf::Vec4 PanelColor{ 0.0f, 0.0f, 0.0f, 0.6f };
+
+      // Purpose: Return the atlas cell of a character's glyph (lowercase is shown as uppercase, and anything else as '?')
+      int glyphCell(char character)
+      {
+         const char upper = static_cast<char>(std::toupper(static_cast<unsigned char>(character)));
+         return (upper >= FirstGlyph && upper <= LastGlyph) ? upper - FirstGlyph : '?' - FirstGlyph;
+      }
+   }
+
+   // Purpose: Set the text shown.  Returns true if it changed.
+   bool HudOverlay::setText(std::string_view _text)
+   {
+      if (_text == text)
+         return false;
+
+      text = _text;
+      buildQuads();
+      return true;
+   }
+
+   // Purpose: Draw the text in the top left corner of the window, with one draw call
+   //    Note: The bodies are drawn untextured (with texture 0, which has no image, bound), so the atlas is unbound afterwards.
+   void HudOverlay::draw(int window_width, int window_height)
+   {
+      if (points.empty())
+         return;
+      if (atlas_texture == 0)
+         buildAtlas();
+
+      // Screen pixels, from the top left corner (leaving the world's view as it was)
+      glMatrixMode(GL_PROJECTION);
+      glPushMatrix();
+      glLoadIdentity();
+      glOrtho(0.0, window_width, window_height, 0.0, -1.0, 1.0);
+      glMatrixMode(GL_MODELVIEW);
+      glPushMatrix();
+      glLoadIdentity();
+
+      static_assert (sizeof(buf::Vec2) == sizeof(GLfloat) * 2);   // Points are passed to OpenGL as tightly packed float pairs
+      static_assert (sizeof(buf::Vec4) == sizeof(GLfloat) * 4);   // and colors as tightly packed float quadruples
+
+      // The overlay sets up the texturing and blending it needs, and puts back what was set before (the texture bound included),
+      // so it does not depend on (or change) the state the bodies are drawn with
+      glPushAttrib(GL_ENABLE_BIT | GL_TEXTURE_BIT | GL_COLOR_BUFFER_BIT);
+      glEnable(GL_TEXTURE_2D);
+      glEnable(GL_BLEND);
+      glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+      glBindTexture(GL_TEXTURE_2D, atlas_texture);
+      glEnableClientState(GL_VERTEX_ARRAY);
+      glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+      glEnableClientState(GL_COLOR_ARRAY);
+      glVertexPointer(2, GL_FLOAT, 0, points.data());
+      glTexCoordPointer(2, GL_FLOAT, 0, texture_points.data());
+      glColorPointer(4, GL_FLOAT, 0, point_colors.data());
+      glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(points.size()));
+      glDisableClientState(GL_COLOR_ARRAY);
+      glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+      glDisableClientState(GL_VERTEX_ARRAY);
+      glPopAttrib();
+
+      glPopMatrix();
+      glMatrixMode(GL_PROJECTION);
+      glPopMatrix();
+      glMatrixMode(GL_MODELVIEW);
+   }
+
+   // Purpose: Make the glyph atlas texture from the built in font
+   //    Each glyph goes in the top left of its cell, as alpha (the color comes from the quad), and the last cell is solid.
+   void HudOverlay::buildAtlas()
+   {
+      std::vector<std::uint8_t> alpha(AtlasWidth * AtlasHeight, 0);
+      auto cellOrigin = [](int cell) { return (cell / AtlasColumns) * CellSize * AtlasWidth + (cell % AtlasColumns) * CellSize; };
+
+      for (int glyph = 0; glyph < static_cast<int>(Font.size()); ++glyph)
+      {
+         for (int column = 0; column < GlyphWidth; ++column)
+         {
+            for (int row = 0; row < GlyphHeight; ++row)
+            {
+               if (Font[glyph][column] & (1 << row))
+                  alpha[cellOrigin(glyph) + row * AtlasWidth + column] = 0xff;
+            }
+         }
+      }
+      for (int row = 0; row < CellSize; ++row)
+         std::fill_n(alpha.begin() + cellOrigin(SolidCell) + row * AtlasWidth, CellSize, std::uint8_t{ 0xff });
+
+      glGenTextures(1, &atlas_texture);
+      glBindTexture(GL_TEXTURE_2D, atlas_texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);   // Whole font pixels (PixelScale screen pixels each), not blurred
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, AtlasWidth, AtlasHeight, 0, GL_ALPHA, GL_UNSIGNED_BYTE, alpha.data());
+      glBindTexture(GL_TEXTURE_2D, 0);
+   }
+
+   // Purpose: Build the quads of the panel and every glyph of the text
+   void HudOverlay::buildQuads()
+   {
+      points.clear();
+      texture_points.clear();
+      point_colors.clear();
+      if (text.empty())
+         return;
+
+      // The panel fits the longest line
+      int line_count = 1;
+      std::size_t longest_line = 0;
+      std::size_t line_length = 0;
+      for (const char character : text)
+      {
+         if (character == '\n')
+         {
+            ++line_count;
+            line_length = 0;
+         }
+         else
+            longest_line = std::max(longest_line, ++line_length);
+      }
+      addQuad(Margin, Margin, static_cast<float>(longest_line * Advance - PixelScale + 2 * Padding),
+         static_cast<float>(line_count * LineHeight - 3 * PixelScale + 2 * Padding), SolidCell, CellSize, CellSize, PanelColor);
+
+      int line = 0;
+      int column = 0;
+      for (const char character : text)
+      {
+         if (character == '\n')
+         {
+            ++line;
+            column = 0;
+            continue;
+         }
+
+         if (character != ' ')
+         {
+            addQuad(static_cast<float>(Margin + Padding + column * Advance), static_cast<float>(Margin + Padding + line * LineHeight),
+               GlyphWidth * PixelScale, GlyphHeight * PixelScale, glyphCell(character), GlyphWidth, GlyphHeight, TextColor);
+         }
+         ++column;
+      }
+   }
+
+   // Purpose: Add a quad (in screen pixels) showing the top left cell_width x cell_height pixels of the atlas cell
+   void HudOverlay::addQuad(float left, float top, float width, float height, int cell, float cell_width, float cell_height, buf::Vec4 color)
+   {
+      const float u_left = static_cast<float>((cell % AtlasColumns) * CellSize) / AtlasWidth;
+      const float v_top = static_cast<float>((cell / AtlasColumns) * CellSize) / AtlasHeight;
+      const float u_right = u_left + cell_width / AtlasWidth;
+      const float v_bottom = v_top + cell_height / AtlasHeight;
+
+      points.insert(points.end(), { { left, top }, { left + width, top }, { left + width, top + height }, { left, top + height } });
+      texture_points.insert(texture_points.end(), { { u_left, v_top }, { u_right, v_top }, { u_right, v_bottom }, { u_left, v_bottom } });
+      point_colors.insert(point_colors.end(), 4, color);
+   }
+} // End namespace bolt::game_engine
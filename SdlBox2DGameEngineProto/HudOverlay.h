@@ -0,0 +1,55 @@
+#pragma once
+// Purpose: An on-screen overlay of text lines (e.g. performance stats) in the top left corner of the window.  The text is drawn
+//          from a glyph atlas: a small texture holding a built in 5x7 pixel font, made once (on the first draw).  The quads of
+//          the text (and of the translucent panel behind it) are only rebuilt when the text changes, and every frame the whole
+//          overlay is drawn with one draw call, so it costs almost nothing however many bodies are in the world.
+//    Note: Only uses OpenGL 1.1 (a texture and client side vertex arrays), like the BatchRenderer.
+//
+
+#include "bolt_buf.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace bolt::game_engine
+{
+   class HudOverlay
+   {
+   public:
+      static constexpr int GlyphWidth = 5;        // Font pixels of each glyph
+      static constexpr int GlyphHeight = 7;
+      static constexpr int CellSize = 8;          // Atlas pixels of each glyph's cell (a glyph, plus empty space so glyphs do not bleed)
+      static constexpr int AtlasColumns = 16;     // Cells across the atlas
+      static constexpr int AtlasRows = 4;         // Cells down the atlas (so 128x32 pixels: a power of two, for OpenGL 1.1)
+      static constexpr int PixelScale = 2;        // Screen pixels of each font pixel
+
+      // Set the text shown: lines separated by '\n' (lowercase is shown as uppercase).  The quads are only rebuilt if the text
+      // changed.  Returns true if it changed (so the display needs redrawing).
+      bool setText(std::string_view _text);
+      // Draw the text in the top left corner of a window of the size (in pixels), with one draw call.  Builds the glyph atlas
+      // the first time (so must be called with the OpenGL context current).  Enables the texturing and blending it needs, and
+      // restores the OpenGL state it changes.
+      void draw(int window_width, int window_height);
+
+      // Get the text shown
+      const std::string& getText() const { return text; };
+
+   private:
+      // Make the glyph atlas texture from the built in font
+      void buildAtlas();
+      // Build the quads of the panel and every glyph of the text
+      void buildQuads();
+      // Add a quad (in screen pixels) showing the atlas cell
+      void addQuad(float left, float top, float width, float height, int cell, float cell_width, float cell_height, buf::Vec4 color);
+
+      std::string text;
+      unsigned int atlas_texture{ 0 };           // OpenGL texture name of the glyph atlas (zero until built)
+
+      //// The overlay's quads, one after another (four points each), in screen pixels from the top left corner
+      std::vector<buf::Vec2> points;
+      std::vector<buf::Vec2> texture_points;     // Each point's position in the atlas
+      std::vector<buf::Vec4> point_colors;       // Each point's RGBA color (multiplied by the atlas)
+   };
+} // End namespace bolt::game_engine
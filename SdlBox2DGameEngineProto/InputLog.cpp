@@ -0,0 +1,265 @@
+#include "InputLog.h"
+#include "bolt_buf.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <type_traits>
+
+#include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
+
+using namespace std::string_literals;
+
+namespace bolt::game_engine
+{
+   using namespace buf;
+
+   namespace
+   {
+      //// Layout of the file: a LogHeader, then the encoded events (see InputLog.h).  The header has no padding (so the file 
+      //   has no uninitialized bytes).
+
+      struct LogHeader
+      {
+         std::uint32_t magic;
+         std::uint32_t version;
+         float time_step;
+         float spawn_lifetime;
+         std::int32_t spawn_interval_steps;
+         std::int32_t spawn_batch;
+         std::int64_t step_count;
+         std::uint64_t state_hash;
+         std::uint64_t event_count;
+         std::uint64_t event_bytes;
+         std::uint8_t destroy_on_contact;
+         std::uint8_t fixed_iterations;
+         std::uint8_t unused[6];
+      };
+      static_assert(sizeof(LogHeader) == 64);
+
+      // Purpose: Append the bytes of a value to the events
+      template <typename T>
+      void append(std::vector<std::byte>& events, const T& value)
+      {
+         static_assert(std::is_trivially_copyable_v<T>);
+         const std::size_t offset = events.size();
+         events.resize(offset + sizeof(T));
+         std::memcpy(events.data() + offset, &value, sizeof(T));
+      }
+
+      // Purpose: Append an unsigned integer, seven bits per byte (low bits first), with the top bit set on every byte but the last
+      void appendVarint(std::vector<std::byte>& events, std::uint64_t value)
+      {
+         while (value >= 0x80)
+         {
+            events.push_back(static_cast<std::byte>((value & 0x7f) | 0x80));
+            value >>= 7;
+         }
+         events.push_back(static_cast<std::byte>(value));
+      }
+
+      // Reads the events in order, failing (rather than reading past the end) if they are cut short
+      class EventReader
+      {
+      public:
+         explicit EventReader(std::span<const std::byte> _bytes) : bytes(_bytes) {};
+
+         // Copy the next value into value.  Returns false if there are too few bytes left.
+         template <typename T>
+         bool read(T& value)
+         {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (bytes.size() - offset < sizeof(T))
+               return false;
+
+            std::memcpy(&value, bytes.data() + offset, sizeof(T));
+            offset += sizeof(T);
+            return true;
+         }
+
+         // Read the next unsigned integer written by appendVarint().  Returns false if it is cut short (or too long).
+         bool readVarint(std::uint64_t& value)
+         {
+            value = 0;
+            for (int shift = 0; shift < 64; shift += 7)
+            {
+               if (offset == bytes.size())
+                  return false;
+
+               const auto byte = std::to_integer<std::uint64_t>(bytes[offset++]);
+               value |= (byte & 0x7f) << shift;
+               if ((byte & 0x80) == 0)
+                  return true;
+            }
+            return false;
+         }
+
+         // Return true if every byte has been read
+         bool atEnd() const { return offset == bytes.size(); };
+
+      private:
+         std::span<const std::byte> bytes;
+         std::size_t offset = 0;
+      };
+   }
+
+   // Purpose: Add an event to the end of the log
+   void InputLog::record(const InputEvent& event)
+   {
+      assert(event.step >= last_step);
+
+      appendVarint(events, static_cast<std::uint64_t>(event.step - last_step));
+      append(events, event.type);
+      switch (event.type)
+      {
+      case InputType::SpawnPrefab:
+         appendVarint(events, event.value);
+         append(events, event.x);
+         append(events, event.y);
+         break;
+      case InputType::SetDestroyOnContact:
+         append(events, static_cast<std::uint8_t>(event.value != 0));
+         break;
+      case InputType::SaveWorld:
+      case InputType::RestoreWorld:
+         break;
+      }
+
+      last_step = event.step;
+      ++event_count;
+   }
+
+   // Purpose: Write the settings and the events to a file (replacing it)
+   Result<void> InputLog::save(const std::string& path, const RunSettings& settings) const
+   {
+      LogHeader header{};
+      header.magic = Magic;
+      header.version = Version;
+      header.time_step = settings.time_step;
+      header.spawn_lifetime = settings.spawn_lifetime;
+      header.spawn_interval_steps = settings.spawn_interval_steps;
+      header.spawn_batch = settings.spawn_batch;
+      header.step_count = settings.step_count;
+      header.state_hash = settings.state_hash;
+      header.event_count = event_count;
+      header.event_bytes = events.size();
+      header.destroy_on_contact = settings.destroy_on_contact;
+      header.fixed_iterations = settings.fixed_iterations;
+
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(events.data()), static_cast<std::streamsize>(events.size()));
+      if (!file)
+         return buf::unexpected(std::format("Could not write the input log: {}", path));
+
+      return Result<void>{};
+   }
+
+   // Purpose: Read a file written by save(), replacing the events.  Returns the settings of the recorded run.
+   Result<InputLog::RunSettings> InputLog::load(const std::string& path)
+   {
+      std::ifstream file(path, std::ios::binary);
+      if (!file)
+         return buf::unexpected(std::format("Could not open the input log: {}", path));
+
+      LogHeader header{};
+      if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || header.magic != Magic)
+         return buf::unexpected(std::format("Not an input log: {}", path));
+      if (header.version != Version)
+         return buf::unexpected(std::format("Input log {} is version {}, not {}.", path, header.version, Version));
+
+      // The settings are applied to the engine as they are, so must be ones it can run with (like --physics-rate's)
+      if (!(header.time_step > 0.0f) || !std::isfinite(header.time_step))
+         return buf::unexpected(std::format("Input log {} has a bad time step ({} seconds).", path, header.time_step));
+      if (std::isnan(header.spawn_lifetime) || header.spawn_interval_steps < 0 || header.spawn_batch < 0)
+         return buf::unexpected(std::format("Input log {} has bad spawn settings (lifetime {}, interval {}, batch {}).", path, 
+            header.spawn_lifetime, header.spawn_interval_steps, header.spawn_batch));
+      // Each event is at least two bytes (its step delta and type), so a larger count is damage (and not room to reserve)
+      if (header.event_count > header.event_bytes / 2)
+         return buf::unexpected(std::format("Input log {} has {} events in {} bytes.", path, header.event_count, header.event_bytes));
+
+      // Check the rest of the file is the events (before allocating room for them)
+      const std::streampos events_start = file.tellg();
+      file.seekg(0, std::ios::end);
+      const std::uint64_t event_bytes = static_cast<std::uint64_t>(file.tellg() - events_start);
+      if (event_bytes != header.event_bytes)
+         return buf::unexpected(std::format("Input log {} has {} bytes of events, not {}.", path, event_bytes, header.event_bytes));
+
+      std::vector<std::byte> file_events(event_bytes);
+      file.seekg(events_start);
+      if (!file.read(reinterpret_cast<char*>(file_events.data()), static_cast<std::streamsize>(file_events.size())))
+         return buf::unexpected(std::format("Could not read the input log: {}", path));
+
+      events = std::move(file_events);
+      event_count = header.event_count;
+      last_step = 0;
+
+      RunSettings settings;
+      settings.time_step = header.time_step;
+      settings.spawn_lifetime = header.spawn_lifetime;
+      settings.destroy_on_contact = header.destroy_on_contact != 0;
+      settings.fixed_iterations = header.fixed_iterations != 0;
+      settings.spawn_interval_steps = header.spawn_interval_steps;
+      settings.spawn_batch = header.spawn_batch;
+      settings.step_count = header.step_count;
+      settings.state_hash = header.state_hash;
+      return settings;
+   }
+
+   // Purpose: Queue every event to be applied before the step it was recorded at
+   //    The whole log is checked before anything is queued, so a bad log queues nothing.
+   Result<void> InputLog::replayInto(InputQueue& input_queue) const
+   {
+      std::vector<InputEvent> decoded;
+      decoded.reserve(event_count);
+
+      EventReader reader(events);
+      std::int64_t step = 0;
+      while (!reader.atEnd())
+      {
+         InputEvent event;
+         std::uint64_t step_delta = 0;
+         if (!reader.readVarint(step_delta) || !reader.read(event.type))
+            return buf::unexpected(std::format("Input log event {} is cut short.", decoded.size()));
+         step += static_cast<std::int64_t>(step_delta);
+         event.step = step;
+
+         bool complete = true;
+         switch (event.type)
+         {
+         case InputType::SpawnPrefab:
+         {
+            std::uint64_t prefab = 0;
+            complete = reader.readVarint(prefab) && reader.read(event.x) && reader.read(event.y);
+            event.value = static_cast<std::uint32_t>(prefab);
+            break;
+         }
+         case InputType::SetDestroyOnContact:
+         {
+            std::uint8_t value = 0;
+            complete = reader.read(value);
+            event.value = value;
+            break;
+         }
+         case InputType::SaveWorld:
+         case InputType::RestoreWorld:
+            break;
+         default:
+            return buf::unexpected(std::format("Input log event {} has an unknown type ({}).", decoded.size(), static_cast<int>(event.type)));
+         }
+         if (!complete)
+            return buf::unexpected(std::format("Input log event {} is cut short.", decoded.size()));
+
+         decoded.push_back(event);
+      }
+
+      if (decoded.size() != event_count)
+         return buf::unexpected(std::format("Input log has {} events, not {}.", decoded.size(), event_count));
+
+      for (const InputEvent& event : decoded)
+         input_queue.push(event);
+      return Result<void>{};
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,64 @@
+#pragma once
+// Purpose: A compact binary log of the inputs applied during a run, each stamped with the physics step it was applied before,
+//          along with the settings of the run.  Replaying the log (headless, as fast as the physics can go) plays the run out
+//          again, so a slow run seen in production can be reproduced exactly and profiled offline, many times faster than 
+//          real time.
+//
+//    Each event is stored as the number of steps since the previous event (a variable length integer, usually one byte), its
+//    type (one byte), and only the data its type uses: a spawn takes about 11 bytes.
+//
+
+#include "bolt_buf.h"
+#include "BodyMetadata.h"
+#include "InputQueue.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace bolt::game_engine
+{
+   class InputLog
+   {
+   public:
+      static constexpr std::uint32_t Magic = 0x314c4942;   // "BIL1" at the start of every log file
+      static constexpr std::uint32_t Version = 1;          // Changes when the layout of the file changes
+
+      // The settings of the recorded run that change how it plays out (so a replay can use the same ones)
+      struct RunSettings
+      {
+         float time_step = Simulation::DefaultTimeStep;
+         float spawn_lifetime = BodyMetadata::Forever;
+         bool destroy_on_contact = false;
+         bool fixed_iterations = false;           // Adaptive iterations depend on the machine's speed, so cannot be replayed exactly
+         std::int32_t spawn_interval_steps = 0;   // Headless spawning (zero if the run had a window)
+         std::int32_t spawn_batch = 1;
+         std::int64_t step_count = 0;             // Physics steps the run took
+         std::uint64_t state_hash = 0;            // State hash after the last step (zero unless the run was deterministic)
+      };
+
+      // Add an event to the end of the log.  Events must be recorded in step order.
+      void record(const InputEvent& event);
+      // Forget every recorded event
+      void clear() { events.clear(); event_count = 0; last_step = 0; };
+      // Number of events recorded
+      std::size_t eventCount() const { return event_count; };
+      // Number of bytes the events take
+      std::size_t size() const { return events.size(); };
+
+      // Write the settings and the events to a file (replacing it)
+      buf::Result<void> save(const std::string& path, const RunSettings& settings) const;
+      // Read a file written by save(), replacing the events.  Returns the settings of the recorded run, or an error (changing 
+      // nothing) if the file is not a log, or its settings or event count could not have been saved.
+      buf::Result<RunSettings> load(const std::string& path);
+      // Queue every event to be applied before the step it was recorded at.  Returns an error if an event is not valid.
+      buf::Result<void> replayInto(InputQueue& input_queue) const;
+
+   private:
+      std::vector<std::byte> events;   // The encoded events
+      std::size_t event_count{ 0 };
+      std::int64_t last_step{ 0 };     // Step of the last event recorded (the next event's step is stored relative to it)
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,34 @@
+
+#include "InputQueue.h"
+
+#include <algorithm>
+
+namespace bolt::game_engine
+{
+   // Purpose: Queue an event to be applied before its step
+   //    Events almost always arrive for the current step (so go on the end), but an event stamped for an earlier step (e.g. 
+   //    from another machine) is put in step order, after any events already queued for its step.
+   void InputQueue::push(const InputEvent& event)
+   {
+      if (events.empty() || events.back().step <= event.step)
+      {
+         events.push_back(event);
+         return;
+      }
+
+      auto position = std::upper_bound(events.begin(), events.end(), event.step, 
+         [](std::int64_t step, const InputEvent& queued) { return step < queued.step; });
+      events.insert(position, event);
+   }
+
+   // Purpose: Take the next event due before the step (queued for that step or an earlier one) into event
+   bool InputQueue::popDue(std::int64_t step, InputEvent& event)
+   {
+      if (events.empty() || events.front().step > step)
+         return false;
+
+      event = events.front();
+      events.pop_front();
+      return true;
+   }
+} // End namespace bolt::game_engine
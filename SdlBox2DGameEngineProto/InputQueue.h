@@ -0,0 +1,52 @@
+#pragma once
+// Purpose: Player inputs that change the simulation (spawning bodies, toggles, saving and restoring the world) are not applied
+//          when they arrive (from a glut callback, at any point in a frame), but queued, each stamped with the physics step it
+//          is applied before.  The engine applies the events due at the start of each step, in order, so the same inputs give 
+//          the same simulation every run (and on every machine in lockstep), however the frames happened to fall.
+//
+
+#include "PrefabRegistry.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+namespace bolt::game_engine
+{
+   // What an input event does
+   enum class InputType : std::uint8_t
+   {
+      SpawnPrefab,            // Spawn the prefab (value) at (x, y)
+      SetDestroyOnContact,    // Destroy dynamic bodies when they touch a static body (value 1) or not (value 0)
+      SaveWorld,              // Save the world (to be restored by RestoreWorld)
+      RestoreWorld,           // Restore the world to the last save, or to the starting scene if nothing was saved
+   };
+
+   struct InputEvent
+   {
+      std::int64_t step = 0;                  // The physics step the event is applied before
+      InputType type = InputType::SpawnPrefab;
+      std::uint32_t value = 0;                // SpawnPrefab: the PrefabHandle.  SetDestroyOnContact: 1 for on, 0 for off.
+      float x = 0.0f;                         // SpawnPrefab: world position
+      float y = 0.0f;
+   };
+
+   class InputQueue
+   {
+   public:
+      // Queue an event to be applied before its step.  Events for the same step are applied in the order they were queued.
+      void push(const InputEvent& event);
+      // Take the next event due before the step (queued for that step or an earlier one) into event.  Returns false if no 
+      // event is due.
+      bool popDue(std::int64_t step, InputEvent& event);
+
+      // Number of events waiting
+      std::size_t size() const { return events.size(); };
+      bool empty() const { return events.empty(); };
+      // Forget every waiting event
+      void clear() { events.clear(); };
+
+   private:
+      std::deque<InputEvent> events;   // Sorted by step (then by the order queued)
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,75 @@
+
+#include "IterationController.h"
+
+#include <algorithm>
+
+namespace bolt::game_engine
+{
+   // Purpose: Record how long the last step took (with current() iterations) and how many contacts the world has, then choose
+   //    the iterations for the next step.  Returns the iterations for the next step.
+   //    Note: Most of a busy step is the solver, which costs about (contacts x iterations), so the measured time of a step 
+   //          predicts what each level would cost.  The level drops at once (to the highest that fits the budget) when over 
+   //          budget, but only rises one level at a time after StepsBeforeRaising steps in a row have room for it, so it does not 
+   //          flip back and forth.
+   IterationController::Iterations IterationController::update(double step_seconds, std::int32_t contact_count)
+   {
+      constexpr double average_weight = 0.2;   // Weight of the newest step in the average
+      constexpr double headroom = 0.8;         // Aim to use this much of the budget, to leave room for the step time varying
+
+      const bool first_step = (average_step_seconds == 0.0);
+      average_step_seconds = first_step ? step_seconds : average_step_seconds + average_weight * (step_seconds - average_step_seconds);
+      average_contact_count = first_step ? contact_count : average_contact_count + average_weight * (contact_count - average_contact_count);
+
+      // Predict the step time at a level from the (average) step time at this level.  If the contacts are growing faster than 
+      // the average keeps up with (e.g. a pile forming), the next steps will cost more, so allow for it.
+      const double contact_growth = std::max(1.0, contact_count / std::max(average_contact_count, 1.0));
+      auto predicted_seconds = [&](std::int32_t at_level) { return contact_growth * average_step_seconds * iterationCount(at_level) / iterationCount(level); };
+
+      const double target_seconds = headroom * step_budget_seconds;
+
+      if (contact_growth * average_step_seconds > step_budget_seconds)
+      {
+         // Over budget: drop straight to the highest level predicted to fit (or the lowest)
+         std::int32_t new_level = level;
+         while (new_level > 0 && predicted_seconds(new_level) > target_seconds)
+            --new_level;
+
+         steps_with_room = 0;
+         setLevel(new_level);
+      }
+      else if (level + 1 < static_cast<std::int32_t>(Levels.size()) && predicted_seconds(level + 1) <= target_seconds)
+      {
+         if (++steps_with_room >= StepsBeforeRaising)
+         {
+            steps_with_room = 0;
+            setLevel(level + 1);
+         }
+      }
+      else
+         steps_with_room = 0;
+
+      return Levels[level];
+   }
+
+   // Purpose: Go back to the default level, and forget the measurements
+   void IterationController::reset()
+   {
+      average_step_seconds = 0.0;
+      level = DefaultLevel;
+      steps_with_room = 0;
+      average_contact_count = 0.0;
+   }
+
+   // Purpose: Change to the level (counting the change)
+   void IterationController::setLevel(std::int32_t new_level)
+   {
+      if (new_level == level)
+         return;
+
+      // The average was measured at the old level, so scale it to what it is expected to be at the new level
+      average_step_seconds *= iterationCount(new_level) / iterationCount(level);
+
+      level = new_level;
+      ++level_change_count;
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,55 @@
+#pragma once
+// Purpose: Chooses Box2D's solver iterations for each physics step.  Fewer iterations when the steps are taking too long (so
+//          frames are not dropped under heavy load), and more when the world is quiet (so stacks and piles are more accurate).
+//
+
+#include <array>
+#include <cstdint>
+
+namespace bolt::game_engine
+{
+   class IterationController
+   {
+   public:
+      struct Iterations
+      {
+         std::int32_t velocity;
+         std::int32_t position;
+      };
+
+      // Settings to choose from, least to most accurate (and slowest).  Level DefaultLevel is the engine's usual 5 and 5.
+      static constexpr std::array<Iterations, 7> Levels{ { {2, 1}, {3, 2}, {4, 3}, {5, 5}, {6, 5}, {8, 6}, {10, 8} } };
+      static constexpr std::int32_t DefaultLevel = 3;
+      static constexpr std::int32_t StepsBeforeRaising = 30;   // Steps in a row that must have room for more, before raising the level
+
+      // Set the time a step may take (seconds)
+      void setStepBudget(double _step_budget_seconds) { step_budget_seconds = _step_budget_seconds; };
+      // The iterations to use for the next step
+      Iterations current() const { return Levels[level]; };
+      // Index of current() in Levels
+      std::int32_t currentLevel() const { return level; };
+      // Recent average time of a step (seconds)
+      double averageStepSeconds() const { return average_step_seconds; };
+      // Number of times the level changed (ever)
+      std::int64_t levelChangeCount() const { return level_change_count; };
+
+      // Record how long the last step took (with current() iterations) and how many contacts the world has, then choose
+      // the iterations for the next step.  Returns the iterations for the next step.
+      Iterations update(double step_seconds, std::int32_t contact_count);
+      // Go back to the default level, and forget the measurements
+      void reset();
+
+   private:
+      // Total solver iterations at the level
+      static double iterationCount(std::int32_t at_level) { return static_cast<double>(Levels[at_level].velocity + Levels[at_level].position); };
+      // Change to the level (counting the change)
+      void setLevel(std::int32_t new_level);
+
+      double step_budget_seconds = 0.5 / 60.0;   // Half the real time a step at 60 Hz represents
+      double average_step_seconds = 0.0;          // Exponential moving average
+      std::int32_t level = DefaultLevel;
+      std::int32_t steps_with_room = 0;           // Steps in a row that had room for the next level up
+      double average_contact_count = 0.0;         // Exponential moving average
+      std::int64_t level_change_count = 0;
+   };
+} // End namespace bolt::game_engine
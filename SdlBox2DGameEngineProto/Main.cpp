@@ -11,17 +11,17 @@
 // Making Box2D Circles (for some other iteration): https://stackoverflow.com/questions/10264012/how-to-create-circles-in-box2d
 
 #include "Engine.h"
+#include "Benchmarks.h"
 
 #include <format>
+#include <string>
+#include <string_view>
+#include <cstdlib>
+#include <cctype>
+#include <algorithm>
 
 #include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
 
-// #1 The tutorial used void pointers to "user data" with user data being int's.  So we need a couple ints to point to, where
-//    the value of the int indicates our custom type - i.e. it is either a "static" box (the platform where boxes land),
-//    or it is a "dynamic" box that we may want to delete.
-const int StaticType = 0;     // We make either static boxes
-const int DynamicType = 1;    // or dynamic boxes
-
 
 // Purpose: The program's main()
 int main(int argc, char* args[])
@@ -30,13 +30,118 @@ int main(int argc, char* args[])
    using Eng = ben::Engine;
 
    int error_code{ 0 }; // Return a non-zero error code from main() to indicate an error
+   Eng engine;
 
-   //// Configure the engine
+   //// Parse the command line
+   //    --headless [steps]         Run the physics only (no window) for a number of steps (default: forever), reporting steps/sec
+   //    --spawn-interval <steps>   In headless mode, spawn triangles every N steps (0 for none)
+   //    --spawn-batch <count>      In headless mode, spawn this many triangles each time (default 1)
+   //    --physics-rate <hz>        Number of (fixed) physics steps per second of simulated time (default 60)
+   //    --adaptive-iterations      Adapt the solver iterations to the load, rather than always using the same ones ('i' toggles it)
+   //    --deterministic            Fixed solver iterations, and hash every body's state after each step (reported with the stats)
+   //    --record <file>            Record every input (stamped with its physics step) to a binary log, written when the run ends
+   //    --replay <file>            Replay a recorded input log headless, as fast as possible, and report how long it took
+   //    --trace <file>             Record the engine's timeline (a Chrome trace) from the start of the run ('t' toggles it)
+   //    --frame-cap <fps>          Redraw the display at most this many times a second (default: no cap)
+   //    --vsync                    Wait for vertical sync when swapping display buffers
+   //    --immediate-render         Draw each body with its own glBegin()/glEnd() rather than one batched draw call per frame
+   //    --no-culling               Draw every body, rather than only the ones on screen
+   //    --no-hud                   Start with the stats overlay hidden ('h' toggles it)
+   //    --destroy-on-contact       Destroy falling bodies as soon as they land on the platform
+   //    --spawn-lifetime <seconds> Destroy spawned triangles and balls this many seconds (of simulated time) after they spawn
+   //    --bench <name>             Run a benchmark (transform, centroid, spawn, step, worlds, snapshot, hash, profile, or "all") instead of the game, then exit
    auto screen_mode = Eng::ScreenMode::NonFullScreen;
-   auto startup_result = Eng::configureEngine(screen_mode);
+   std::int64_t headless_steps = 0;
+   std::int32_t spawn_interval_steps = 30;
+   std::int32_t spawn_batch = 1;
+   float frame_cap = 0.0f;
+   bool vsync = false;
+   std::string replay_path;
+
+   for (int arg_index = 1; arg_index < argc; ++arg_index)
+   {
+      const std::string_view arg{ args[arg_index] };
+      const bool has_value = (arg_index + 1 < argc) && std::isdigit(static_cast<unsigned char>(args[arg_index + 1][0]));
+
+      if (arg == "--headless")
+      {
+         screen_mode = Eng::ScreenMode::Headless;
+         if (has_value)
+            headless_steps = std::strtoll(args[++arg_index], nullptr, 10);
+      }
+      else if (arg == "--spawn-interval" && has_value)
+         spawn_interval_steps = std::atoi(args[++arg_index]);
+      else if (arg == "--spawn-batch" && has_value)
+         spawn_batch = std::max(1, std::atoi(args[++arg_index]));
+      else if (arg == "--physics-rate" && has_value)
+      {
+         if (auto rate_result = engine.setPhysicsRate(static_cast<float>(std::atof(args[++arg_index])), 5 /*max_steps_per_frame*/); !rate_result)
+         {
+            std::cerr << "Invalid --physics-rate: " << rate_result.error() << std::endl;
+            return 1;
+         }
+      }
+      else if (arg == "--adaptive-iterations")
+         engine.setAdaptiveIterations(true);
+      else if (arg == "--deterministic")
+         engine.setDeterministic(true);
+      else if (arg == "--record" && arg_index + 1 < argc)
+         engine.setInputRecording(args[++arg_index]);
+      else if (arg == "--replay" && arg_index + 1 < argc)
+         replay_path = args[++arg_index];
+      else if (arg == "--trace" && arg_index + 1 < argc)
+         engine.setTraceRecording(args[++arg_index], true);
+      else if (arg == "--frame-cap" && has_value)
+         frame_cap = static_cast<float>(std::atof(args[++arg_index]));
+      else if (arg == "--vsync")
+         vsync = true;
+      else if (arg == "--immediate-render")
+         engine.setRenderPath(Eng::RenderPath::Immediate);
+      else if (arg == "--no-hud")
+         engine.setHudVisible(false);
+      else if (arg == "--no-culling")
+         engine.setCulling(false);
+      else if (arg == "--destroy-on-contact")
+         engine.setDestroyOnContact(true);
+      else if (arg == "--spawn-lifetime" && has_value)
+         engine.setSpawnLifetime(static_cast<float>(std::atof(args[++arg_index])));
+      else if (arg == "--bench" && arg_index + 1 < argc)
+      {
+         if (auto bench_result = ben::Benchmarks::run(args[++arg_index]); !bench_result)
+         {
+            std::cerr << "Benchmark failed: " << bench_result.error() << std::endl;
+            return 1;
+         }
+         return 0;
+      }
+      else
+         std::cerr << "Ignoring unknown command line argument: " << arg << std::endl;
+   }
+
+   engine.setHeadlessOptions(headless_steps, spawn_interval_steps, spawn_batch);
+   engine.setFramePolicy(frame_cap, vsync);
+
+   // A replay runs headless, with the recorded run's settings (replacing any given above)
+   if (!replay_path.empty())
+   {
+      if (auto replay_result = engine.setInputReplay(replay_path); !replay_result)
+      {
+         std::cerr << "Replay failed: " << replay_result.error() << std::endl;
+         return 1;
+      }
+      screen_mode = Eng::ScreenMode::Headless;
+   }
+
+   //// Configure the engine
+   auto startup_result = engine.configureEngine(screen_mode);
 
    //// If config went okay
-   if (startup_result)
+   if (startup_result && screen_mode == Eng::ScreenMode::Headless)
+   {
+      std::cout << "Running headless (no window). Press Ctrl-C to exit." << std::endl;
+      startup_result = engine.runEngine();
+   }
+   else if (startup_result)
    {
       std::cout << std::endl;
       const auto& [x_min, y_min, x_max, y_max] = Eng::getWorldDisplayedInMetersNominal();
@@ -48,11 +153,21 @@ int main(int argc, char* args[])
       std::cout << std::endl;
       std::cout << "Instructions:" << std::endl;
       std::cout << " - Click mouse in window to create a block that falls." << std::endl;
+      std::cout << " - Right click mouse in window to create a ball that falls." << std::endl;
+      std::cout << " - Press 'f' to toggle reporting frame rate and CPU use." << std::endl;
+      std::cout << " - Press 'h' to toggle the stats overlay (frame rate, step and render time, body and contact counts)." << std::endl;
+      std::cout << " - Press 'p' to print where the frame time goes (p50, p99 and max of each phase)." << std::endl;
+      std::cout << " - Press 't' to start/stop recording a timeline of the frames (to trace.json, or the --trace file) for chrome://tracing." << std::endl;
+      std::cout << " - Press 'b' to toggle between batched and immediate (per body) rendering." << std::endl;
+      std::cout << " - Press 'c' to toggle culling (not drawing) bodies that are off screen." << std::endl;
+      std::cout << " - Press 'i' to toggle adapting the physics solver iterations to the load." << std::endl;
+      std::cout << " - Press 'k' to toggle destroying blocks when they land." << std::endl;
+      std::cout << " - Press 's' to save the world, and 'r' to restore it (to the last save, or the starting scene)." << std::endl;
       std::cout << " - Press ESC to exit." << std::endl;
 
       //// Start running the engine
       // !! NOTE: This will not return until the engine exists
-      startup_result = Eng::runEngine();
+      startup_result = engine.runEngine();
    }
 
    //// Handle errors
@@ -0,0 +1,43 @@
+
+#include "PrefabRegistry.h"
+
+#include <format>
+#include <string>
+
+using namespace std::string_literals;
+
+namespace bolt::game_engine
+{
+   // Purpose: Add a convex polygon prefab (points in body coordinates).  Returns an error if the points do not make a valid polygon.
+   buf::Result<PrefabHandle> PrefabRegistry::addPolygon(std::span<const buf::Vec2> points, b2BodyType body_type, float density, const BodyMetadata& metadata)
+   {
+      if (points.size() < 3 || points.size() > b2_maxPolygonVertices)
+         return buf::unexpected{ std::format("A polygon prefab needs 3 to {} points (not {}).", b2_maxPolygonVertices, points.size()) };
+
+      Prefab prefab{ body_type, ShapeKind::Polygon, {}, {}, density, {}, metadata };
+
+      // Set() computes the convex hull (and fails if the points are too close together to make one)
+      if (!prefab.polygon.Set(buf::cvert(points.data()), static_cast<int32>(points.size())))
+         return buf::unexpected("The points of a polygon prefab do not make a convex polygon with any area."s);
+
+      prefab.polygon.ComputeMass(&prefab.mass_data, density);
+
+      prefabs.push_back(prefab);
+      return static_cast<PrefabHandle>(prefabs.size() - 1);
+   }
+
+   // Purpose: Add a circle prefab (center in body coordinates).  Returns an error if the radius is not positive.
+   buf::Result<PrefabHandle> PrefabRegistry::addCircle(b2Vec2 center, float radius, b2BodyType body_type, float density, const BodyMetadata& metadata)
+   {
+      if (!(radius > 0.0f))
+         return buf::unexpected{ std::format("A circle prefab needs a positive radius (not {}).", radius) };
+
+      Prefab prefab{ body_type, ShapeKind::Circle, {}, {}, density, {}, metadata };
+      prefab.circle.m_p = center;
+      prefab.circle.m_radius = radius;
+      prefab.circle.ComputeMass(&prefab.mass_data, density);
+
+      prefabs.push_back(prefab);
+      return static_cast<PrefabHandle>(prefabs.size() - 1);
+   }
+} // End namespace bolt::game_engine
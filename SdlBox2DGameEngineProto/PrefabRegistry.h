@@ -0,0 +1,78 @@
+#pragma once
+// Purpose: Body templates (prefabs) for spawning the same kind of body many times.  A prefab's shape is validated, hulled and 
+//          its mass data computed once, when the prefab is added, rather than every time a body is created from it.
+//
+
+#include "bolt_buf.h"
+#include "BodyMetadata.h"
+#include "ShapeRegistry.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   // Index of a prefab in the PrefabRegistry
+   using PrefabHandle = std::uint32_t;
+
+   struct Prefab
+   {
+      b2BodyType body_type;
+      ShapeKind shape_kind;
+      b2PolygonShape polygon;       // ShapeKind::Polygon: the (already hulled) shape
+      b2CircleShape circle;         // ShapeKind::Circle: the shape
+      float density;
+      b2MassData mass_data;         // Mass of a body with the shape and density (computed once)
+      BodyMetadata metadata;        // Metadata given to each body created from the prefab
+      std::uint32_t shape_count = 1;   // Fixtures each body gets (so shapes it adds to the ShapeRegistry)
+   };
+
+   class PrefabRegistry
+   {
+   public:
+      // Add a convex polygon prefab (points in body coordinates).  Returns an error if the points do not make a valid polygon.
+      buf::Result<PrefabHandle> addPolygon(std::span<const buf::Vec2> points, b2BodyType body_type, float density, const BodyMetadata& metadata);
+      // Add a circle prefab (center in body coordinates).  Returns an error if the radius is not positive.
+      buf::Result<PrefabHandle> addCircle(b2Vec2 center, float radius, b2BodyType body_type, float density, const BodyMetadata& metadata);
+
+      // Create a body from the prefab at each world position, calling on_created(b2Body*) for each new body.
+      //    Note: The definitions are built once for all the bodies, and each body gets the prefab's (already computed) shape 
+      //          and mass.  Box2D just copies the shape when creating the fixture, so no convex hull or mass is computed here.
+      template <typename Func>
+      void createBodies(b2World& world, PrefabHandle handle, std::span<const b2Vec2> positions, Func&& on_created) const
+      {
+         const Prefab& prefab = prefabs[handle];
+
+         b2BodyDef bodydef;
+         bodydef.type = prefab.body_type;
+
+         b2FixtureDef fixture_def;
+         fixture_def.shape = (prefab.shape_kind == ShapeKind::Polygon) ? static_cast<const b2Shape*>(&prefab.polygon) : &prefab.circle;
+         fixture_def.density = 0.0f;   // So CreateFixture() does not compute the body's mass (it is set from the prefab below)
+
+         for (const b2Vec2& position : positions)
+         {
+            bodydef.position = position;
+            b2Body* body = world.CreateBody(&bodydef);
+
+            b2Fixture* fixture = body->CreateFixture(&fixture_def);
+            fixture->SetDensity(prefab.density);   // Does not recompute the mass
+            body->SetMassData(&prefab.mass_data);
+
+            on_created(body);
+         }
+      }
+
+      const Prefab& operator[](PrefabHandle handle) const { return prefabs[handle]; };
+      // Number of prefabs (handles are less than this)
+      std::size_t size() const { return prefabs.size(); };
+      // Forget all prefabs
+      void clear() { prefabs.clear(); };
+
+   private:
+      std::vector<Prefab> prefabs;
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,44 @@
+
+#include "ShapeRegistry.h"
+
+#include <algorithm>
+
+namespace bolt::game_engine
+{
+   // Purpose: Record the shapes of every fixture on the body.  Call once, after all of the body's fixtures are created.
+   void ShapeRegistry::addBody(const b2Body* body)
+   {
+      for (const b2Fixture* fixture = body->GetFixtureList(); fixture != nullptr; fixture = fixture->GetNext())
+      {
+         const b2Shape* shape = fixture->GetShape();
+
+         // Note: b2Shape::GetType() is a plain member read, so no dynamic_cast<> is needed to find the kind of shape
+         switch (shape->GetType())
+         {
+         case b2Shape::e_polygon:
+         {
+            const auto* polygon = static_cast<const b2PolygonShape*>(shape);
+            render_shapes.push_back({ body, ShapeKind::Polygon, polygon->m_count, polygon->m_vertices, b2Vec2(0.0f, 0.0f), 0.0f });
+            break;
+         }
+         case b2Shape::e_circle:
+         {
+            const auto* circle = static_cast<const b2CircleShape*>(shape);
+            render_shapes.push_back({ body, ShapeKind::Circle, 0, nullptr, circle->m_p, circle->m_radius });
+            break;
+         }
+         default:
+            break;   // Edges and chains have no area, so are not drawn
+         }
+      }
+   }
+
+   // Purpose: Forget the shapes of the bodies (call before the bodies are destroyed).  The bodies must be sorted by address.
+   void ShapeRegistry::removeBodies(std::span<b2Body* const> sorted_bodies)
+   {
+      std::erase_if(render_shapes, [sorted_bodies](const RenderShape& shape) 
+      { 
+         return std::binary_search(sorted_bodies.begin(), sorted_bodies.end(), shape.body, std::less<const b2Body*>{});
+      });
+   }
+} // End namespace bolt::game_engine
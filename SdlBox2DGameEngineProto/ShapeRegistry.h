@@ -0,0 +1,47 @@
+#pragma once
+// Purpose: Render side record of the shapes of every body in the world.  Shapes are recorded once when a body is added, 
+//          so rendering can just switch on the recorded kind (no RTTI, and no walking each body's fixture list every frame).
+//
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   enum class ShapeKind : std::uint8_t { Polygon, Circle };
+
+   // The shape of one fixture of a body, in body (local) coordinates
+   struct RenderShape
+   {
+      const b2Body* body;          // Body the shape (fixture) belongs to
+      ShapeKind kind;
+      std::int32_t vertex_count;   // Polygon: number of vertices
+      const b2Vec2* vertices;      // Polygon: vertices (owned by the Box2D fixture, so valid while the fixture exists)
+      b2Vec2 center;               // Circle: center
+      float radius;                // Circle: radius
+   };
+
+   class ShapeRegistry
+   {
+   public:
+      // Record the shapes of every fixture on the body.  Call once, after all of the body's fixtures are created.
+      //    Note: Edge and chain shapes are not recorded (they have no area to draw).
+      void addBody(const b2Body* body);
+      // Forget the shapes of the bodies (call before the bodies are destroyed).  The bodies must be sorted by address.
+      //    Note: The remaining shapes keep their order.
+      void removeBodies(std::span<b2Body* const> sorted_bodies);
+
+      // All recorded shapes.  The shapes of a body are next to each other, and bodies are in the order they were added.
+      std::span<const RenderShape> shapes() const { return render_shapes; };
+      // Forget all shapes
+      void clear() { render_shapes.clear(); };
+      // Make room for shape_count more shapes (e.g. before adding many bodies at once)
+      void reserve(std::size_t shape_count) { render_shapes.reserve(render_shapes.size() + shape_count); };
+
+   private:
+      std::vector<RenderShape> render_shapes;
+   };
+} // End namespace bolt::game_engine
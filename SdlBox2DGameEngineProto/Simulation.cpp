@@ -0,0 +1,410 @@
+
+#include "Simulation.h"
+#include "bolt_buf.h"
+
+#include <Box2D/Box2D.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <format>
+#include <mutex>
+
+#include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
+
+namespace bolt::game_engine
+{
+   using namespace buf;
+
+   namespace
+   {
+      // Purpose: Make Box2D fill in its (global) table of contact functions, once, before any world is stepped.
+      //    Note: Box2D fills the table the first time any world creates a contact, which is a data race when two worlds do
+      //          that at the same time on different threads.  Filling it here first (on whichever thread creates the first
+      //          world) means worlds only ever read it.
+      void primeBox2DContactRegisters()
+      {
+         static std::once_flag primed;
+         std::call_once(primed, []()
+         {
+            b2World world(b2Vec2(0.0f, 0.0f));
+
+            b2CircleShape shape;
+            shape.m_radius = 1.0f;
+
+            b2BodyDef bodydef;
+            world.CreateBody(&bodydef)->CreateFixture(&shape, 0.0f /*density*/);
+            bodydef.type = b2_dynamicBody;
+            world.CreateBody(&bodydef)->CreateFixture(&shape, 1.0f /*density*/);
+
+            world.Step(Simulation::DefaultTimeStep, 1, 1);   // The overlapping circles make a contact
+         });
+      }
+   }
+
+   // Purpose: Construct a simulation (with no world until createWorld())
+   Simulation::Simulation(const b2AABB& _kill_volume) : kill_volume(_kill_volume)
+   {
+      contact_listener.setBodyMetadata(&body_metadata);
+      iteration_controller.setStepBudget(PhysicsBudgetFraction * time_step);
+   }
+
+   // Purpose: Create a new (empty) world with the gravity, destroying any previous world and its bodies and resetting the counts
+   void Simulation::createWorld(b2Vec2 gravity)
+   {
+      primeBox2DContactRegisters();
+
+      world.reset();   // Destroys the bodies (before the tables they are registered in are cleared)
+      contact_listener.drainEvents([](const ContactEvent&) {});
+      destruction_queue.takeBatch();
+      shape_registry.clear();
+      transform_mirror.clear();
+      body_metadata.clear();
+
+      destroyed_body_count = 0;
+      spawned_body_count = 0;
+      despawned_body_count = 0;
+      contact_counts = ContactCounts{};
+      iteration_controller.reset();
+
+      world = std::make_unique<b2World>(gravity);
+      world->SetContactListener(&contact_listener);
+   }
+
+   // Purpose: Destroy every body, keeping the world (and the memory of the tables)
+   void Simulation::clearBodies()
+   {
+      assert(world != nullptr);
+
+      contact_listener.setRecording(false);   // DestroyBody() ends the body's contacts, and those events would point to destroyed bodies
+      for (b2Body* body = world->GetBodyList(); body != nullptr;)
+      {
+         b2Body* next_body = body->GetNext();
+         world->DestroyBody(body);
+         body = next_body;
+      }
+      contact_listener.setRecording(true);
+
+      contact_listener.drainEvents([](const ContactEvent&) {});
+      destruction_queue.takeBatch();
+      shape_registry.clear();
+      transform_mirror.clear();
+      body_metadata.clear();
+   }
+
+   // Purpose: Set the seconds of simulated time per step
+   void Simulation::setTimeStep(float seconds)
+   {
+      assert(seconds > 0.0f);
+      time_step = seconds;
+      iteration_controller.setStepBudget(PhysicsBudgetFraction * time_step);
+   }
+
+   // Purpose: Add a new polygon to the (Box2D) world of object.
+   //       - if true the object bounce around in the physical world.
+   //       - If false the object is "static" and acts like a rigid, fixed platform (that probably never moves in the scene).
+   b2Body* Simulation::addPolygon(float x_center_world, float y_center_world, const std::vector<buf::Vec2>& verts, bool dynamic_object)
+   {
+      // https://gamedev.stackexchange.com/questions/1496/using-the-box2d-polygon-set-function
+
+      b2BodyDef bodydef;
+      bodydef.position.Set(x_center_world, y_center_world);
+      bodydef.type = (dynamic_object) ? b2_dynamicBody : b2_staticBody;
+
+      b2Body* body = world->CreateBody(&bodydef);
+
+      b2PolygonShape shape;
+      assert(verts.size() <= 8); // Polygons are limited to 8 vertices
+
+      shape.Set(cvert(&verts[0]), (int32)verts.size());
+
+      b2FixtureDef fixture_def;
+      fixture_def.shape = &shape;   // Note: "shape" is specifically documented to state that it will be cloned, so can be on stack.
+      fixture_def.density = 1.0;
+
+      body->CreateFixture(&fixture_def);
+
+      // #1 When a collision happens we need to know the type of the box/body, so it is recorded in the body's metadata
+      registerBody(body, { .kind = (dynamic_object) ? BodyKind::Dynamic : BodyKind::Static,
+                           .render_style = (dynamic_object) ? RenderStyle::Block : RenderStyle::Platform });
+
+      return body;
+   }
+
+   // Purpose: Add a new rectangle to the (Box2D) world of object.
+   //   dynamic_object:
+   //       - if true the object bounce around in the physical world.
+   //       - If false the object is "static" and acts like a rigid, fixed platform (that probably never moves in the scene).
+   b2Body* Simulation::addRect(float x_center_world, float y_center_world, float width, float height, bool dynamic_object)
+   {
+      b2BodyDef bodydef;
+      bodydef.position.Set(x_center_world, y_center_world);
+      bodydef.type = (dynamic_object) ? b2_dynamicBody : b2_staticBody;
+
+      b2Body* body = world->CreateBody(&bodydef);
+
+      b2PolygonShape shape;   // Polygons are limited to 8 vertices
+      shape.SetAsBox(width / 2, height / 2);
+
+      b2FixtureDef fixture_def;
+      fixture_def.shape = &shape;   // Note: "shape" is specifically documented to state that it will be cloned, so can be on stack.
+      fixture_def.density = 1.0;
+
+      body->CreateFixture(&fixture_def);
+
+      // #1 When a collision happens we need to know the type of the box/body, so it is recorded in the body's metadata
+      registerBody(body, { .kind = (dynamic_object) ? BodyKind::Dynamic : BodyKind::Static,
+                           .render_style = (dynamic_object) ? RenderStyle::Block : RenderStyle::Platform });
+
+      return body;
+   }
+
+   // Purpose: Add a new circle to the (Box2D) world of object.
+   //   dynamic_object:
+   //       - if true the object bounce around in the physical world.
+   //       - If false the object is "static" and acts like a rigid, fixed platform (that probably never moves in the scene).
+   b2Body* Simulation::addCircle(float x_center_world, float y_center_world, float radius, bool dynamic_object)
+   {
+      // https://stackoverflow.com/questions/10264012/how-to-create-circles-in-box2d
+      b2BodyDef bodydef;
+      bodydef.position.Set(x_center_world, y_center_world);
+      bodydef.type = (dynamic_object) ? b2_dynamicBody : b2_staticBody;
+
+      b2Body* body = world->CreateBody(&bodydef);
+
+      b2CircleShape shape;
+      shape.m_radius = radius;
+
+      b2FixtureDef fixture_def;
+      fixture_def.shape = &shape;   // Note: "shape" is specifically documented to state that it will be cloned, so can be on stack.
+      fixture_def.density = 1.0;
+
+      body->CreateFixture(&fixture_def);
+
+      // #1 When a collision happens we need to know the type of the box/body, so it is recorded in the body's metadata
+      registerBody(body, { .kind = (dynamic_object) ? BodyKind::Dynamic : BodyKind::Static,
+                           .render_style = (dynamic_object) ? RenderStyle::Ball : RenderStyle::Platform });
+
+      return body;
+   }
+
+   // Purpose: Record a newly created body (after its fixtures are created) so it is classified, mirrored and drawn.  Returns its handle.
+   BodyHandle Simulation::registerBody(b2Body* body, const BodyMetadata& metadata)
+   {
+      const BodyHandle handle = body_metadata.add(body, metadata);   // Also saves the handle in the body's user data
+
+      const auto first_shape = static_cast<std::uint32_t>(shape_registry.shapes().size());
+      shape_registry.addBody(body);
+      const auto shape_count = static_cast<std::uint32_t>(shape_registry.shapes().size()) - first_shape;
+
+      transform_mirror.addBody(body, handle, first_shape, shape_count);
+      ++spawned_body_count;
+      return handle;
+   }
+
+   // Purpose: Spawn a body from a prefab at the world coordinates.  Returns the new body.
+   b2Body* Simulation::spawnPrefab(const PrefabRegistry& prefab_registry, PrefabHandle prefab, float x_world, float y_world)
+   {
+      const b2Vec2 position(x_world, y_world);
+      spawnMany(prefab_registry, prefab, std::span<const b2Vec2>(&position, 1));
+
+      return body_metadata[transform_mirror.handles().back()].body;   // The body just added
+   }
+
+   // Purpose: Spawn a body from the prefab at each world position.  Returns the number of bodies spawned.
+   std::size_t Simulation::spawnMany(const PrefabRegistry& prefab_registry, PrefabHandle prefab, std::span<const b2Vec2> positions)
+   {
+      BUF_TRACE_SCOPE("spawn");
+      BodyMetadata metadata = prefab_registry[prefab].metadata;
+      metadata.lifetime = std::min(metadata.lifetime, spawn_lifetime);
+
+      // A new body's handle is a free handle or the next one past the table, so every handle is below capacity + count
+      shape_registry.reserve(positions.size() * prefab_registry[prefab].shape_count);
+      transform_mirror.reserve(positions.size(), body_metadata.capacity() + positions.size());
+
+      prefab_registry.createBodies(*world, prefab, positions, [this, &metadata](b2Body* body) { registerBody(body, metadata); });
+
+      return positions.size();
+   }
+
+   // Purpose: Mark a body to be destroyed after the current step (safe to call at any time, including from Box2D callbacks)
+   void Simulation::markForDestruction(b2Body* body)
+   {
+      const BodyHandle handle = BodyMetadataTable::handleOf(body);
+      assert(handle != InvalidBodyHandle);
+
+      // Queue each body once, however many times it is marked
+      auto& flags = body_metadata[handle].flags;
+      if (flags & BodyMetadata::MarkedForDestruction)
+         return;
+
+      flags |= BodyMetadata::MarkedForDestruction;
+      destruction_queue.markForDestruction(body);
+   }
+
+   // Purpose: Step the world once, then handle its contact events, expired bodies and bodies out of the kill volume.  Returns
+   //    the number of bodies destroyed.
+   std::size_t Simulation::step()
+   {
+      BUF_TRACE_SCOPE("step");
+      using Clock = std::chrono::steady_clock;
+
+      // The iterations affect the accuracy and overhead of collision detection and position calculations
+      const auto iterations = (adaptive_iterations) ? iteration_controller.current() : IterationController::Iterations{ VelocityIterations, PositionIterations };
+
+      const auto step_start = Clock::now();
+      {
+         BUF_TRACE_SCOPE("world_step");
+         world->Step(time_step /*amount of time that passed*/, iterations.velocity, iterations.position);
+      }
+
+      if (adaptive_iterations)
+         iteration_controller.update(std::chrono::duration<double>(Clock::now() - step_start).count(), world->GetContactCount());
+
+      {
+         BUF_TRACE_SCOPE("contact_processing");
+         processContactEvents();                                 // React to the collisions that happened during the step
+      }
+
+      std::size_t destroyed_count = 0;
+      {
+         BUF_TRACE_SCOPE("destroy_bodies");
+         expireBodies();                                         // Bodies whose time is up are destroyed along with the ones the collisions marked
+         destroyed_count = destroyMarkedBodies();                // Now the step is over, it is safe to destroy bodies
+      }
+
+      transform_mirror.refresh();   // Copy the new transforms out of Box2D, once, for everything that reads them until the next step
+      despawnOutOfBounds();         // Bodies that left the world are destroyed after the next step
+
+      return destroyed_count;
+   }
+
+   // Purpose: Handle the contact events recorded during the last step (gameplay reactions to collisions go here)
+   //    Note: Define PRINT_CONTACT_EVENTS to print every event (which is slow when many bodies pile up).
+   void Simulation::processContactEvents()
+   {
+      contact_listener.drainEvents([this](const ContactEvent& event)
+      {
+         switch (event.type)
+         {
+         case ContactEvent::Type::Begin:
+            ++contact_counts.begin;
+
+            // Destroy dynamic bodies that land on something static (e.g. the platform)
+            if (destroy_on_contact && body_metadata[event.body_a].kind != body_metadata[event.body_b].kind)
+            {
+               const BodyHandle dynamic_body = (body_metadata[event.body_a].kind == BodyKind::Dynamic) ? event.body_a : event.body_b;
+               markForDestruction(body_metadata[dynamic_body].body);
+            }
+            break;
+         case ContactEvent::Type::End:    ++contact_counts.end; break;
+         case ContactEvent::Type::Impact: ++contact_counts.impact; break;
+         }
+
+#ifdef PRINT_CONTACT_EVENTS
+         dbg(__func__); dbg((int)event.type); dbg(event.point.x); dbg(event.point.y); dbgln(event.normal_impulse);
+#endif
+      });
+   }
+
+   // Purpose: Count down the lifetime of every body, and mark the bodies whose time is up for destruction
+   void Simulation::expireBodies()
+   {
+      body_metadata.forEach([this](BodyHandle handle, BodyMetadata& metadata)
+      {
+         metadata.lifetime -= time_step;   // Forever (infinity) stays forever
+         if (metadata.lifetime <= 0.0f)
+            markForDestruction(metadata.body);
+      });
+   }
+
+   // Purpose: Mark the dynamic bodies whose position is outside the kill volume for destruction.  Returns the number marked.
+   //    Note: Streams through the transform mirror (no Box2D calls), so testing every body costs little.  Sleeping bodies are
+   //          tested too: a body that came to rest outside (e.g. on something beyond the world, or after the kill volume 
+   //          shrank) must still go, or the body count is not bounded.
+   std::size_t Simulation::despawnOutOfBounds()
+   {
+      const auto x = transform_mirror.x();
+      const auto y = transform_mirror.y();
+      const auto flags = transform_mirror.flags();
+      const auto handles = transform_mirror.handles();
+
+      const float x_min = kill_volume.lowerBound.x;
+      const float y_min = kill_volume.lowerBound.y;
+      const float x_max = kill_volume.upperBound.x;
+      const float y_max = kill_volume.upperBound.y;
+
+      std::size_t marked_count = 0;
+      for (std::size_t body_index = 0; body_index < transform_mirror.size(); ++body_index)
+      {
+         const bool outside = (x[body_index] < x_min) | (x[body_index] > x_max) | (y[body_index] < y_min) | (y[body_index] > y_max);
+         if (!outside || !(flags[body_index] & TransformMirror::Dynamic))
+            continue;
+
+         BodyMetadata& metadata = body_metadata[handles[body_index]];
+         if (metadata.flags & BodyMetadata::MarkedForDestruction)
+            continue;   // Already going (and counted elsewhere)
+
+         markForDestruction(metadata.body);
+         ++marked_count;
+      }
+
+      despawned_body_count += marked_count;
+      return marked_count;
+   }
+
+   // Purpose: Destroy every body marked for destruction, as one batch.  Returns the number of bodies destroyed.
+   //    Note: Must not be called during a step (i.e. from a Box2D callback).
+   std::size_t Simulation::destroyMarkedBodies()
+   {
+      const auto batch = destruction_queue.takeBatch();   // Each marked body once, sorted
+      if (batch.empty())
+         return 0;
+
+      // Forget the bodies (in one pass over each) before they are destroyed
+      shape_registry.removeBodies(batch);
+      transform_mirror.removeBodies(batch);
+
+      contact_listener.setRecording(false);   // DestroyBody() ends the body's contacts, and those events would point to destroyed bodies
+      for (b2Body* body : batch)
+      {
+         body_metadata.remove(BodyMetadataTable::handleOf(body));
+         world->DestroyBody(body);
+      }
+      contact_listener.setRecording(true);
+
+      destroyed_body_count += batch.size();
+      return batch.size();
+   }
+
+   // Purpose: Return true if any (non-static) body is awake, i.e. it may still be moving
+   bool Simulation::anyBodyAwake() const
+   {
+      // Note: Box2D never marks static bodies as awake
+      for (const std::uint8_t flags : transform_mirror.flags())
+      {
+         if (flags & TransformMirror::Awake)
+            return true;
+      }
+      return false;
+   }
+
+   // Purpose: Return the number of (non-static) bodies awake
+   std::int64_t Simulation::awakeBodyCount() const
+   {
+      const auto flags = transform_mirror.flags();
+      return std::count_if(flags.begin(), flags.end(), [](std::uint8_t body_flags) { return (body_flags & TransformMirror::Awake) != 0; });
+   }
+
+   // Purpose: Return a line describing the solver iterations being used (and how they were chosen)
+   std::string Simulation::iterationsReport() const
+   {
+      if (!adaptive_iterations)
+         return std::format("Iterations: fixed  velocity {} position {}", VelocityIterations, PositionIterations);
+
+      const auto iterations = iteration_controller.current();
+      return std::format("Iterations: adaptive  velocity {} position {}  (level {} of {}, average step {:.3f} ms, budget {:.3f} ms, changed {} times)",
+         iterations.velocity, iterations.position, iteration_controller.currentLevel(), IterationController::Levels.size() - 1,
+         iteration_controller.averageStepSeconds() * 1000.0, PhysicsBudgetFraction * time_step * 1000.0, iteration_controller.levelChangeCount());
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,164 @@
+#pragma once
+// Purpose: One independent physics simulation: a Box2D world with its own contact listener (and event queue), body metadata,
+//          shapes, transform mirror, destruction queue and solver iteration controller.  None of the engine's state is shared
+//          between simulations, so several can be stepped at the same time on different threads, with one exception in Box2D:
+//    Note: Box2D 2.4 is not fully isolated.  b2Distance() and b2TimeOfImpact() update global statistics on every step 
+//          (b2_gjkCalls, b2_gjkIters, b2_gjkMaxIters, b2_toiCalls, b2_toiIters, b2_toiMaxIters, b2_toiTime and 
+//          b2_toiMaxTime) without synchronization, so stepping worlds in parallel is a data race on them: undefined behavior 
+//          by the standard, and reported by ThreadSanitizer (suppress b2Distance and b2TimeOfImpact there).  It is benign on
+//          the targets we build for (x86-64 and ARM64 with MSVC, gcc or clang): the counters are aligned 32-bit ints and 
+//          floats, whose loads and stores do not tear, and nothing in Box2D (or the engine) reads them back, so only the 
+//          statistics come out wrong and the simulations are unaffected.  Build Box2D with those updates removed to be rid
+//          of the race completely.
+//
+
+#include "bolt_buf.h"
+#include "ContactListener.h"
+#include "ShapeRegistry.h"
+#include "TransformMirror.h"
+#include "BodyDestructionQueue.h"
+#include "BodyMetadata.h"
+#include "PrefabRegistry.h"
+#include "IterationController.h"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   class Simulation
+   {
+   public:
+      // Iterations of Box2D's velocity and position solvers per physics step (more is more accurate, and slower), when the
+      // iterations are not adaptive
+      static constexpr std::int32_t VelocityIterations = 5;
+      static constexpr std::int32_t PositionIterations = 5;
+
+      static constexpr float DefaultTimeStep = 1.0f / 60.0f;   // Seconds of simulated time per step
+      static constexpr double PhysicsBudgetFraction = 0.5;     // Fraction of the real time a step represents, that the step may take
+
+      // Counts of the bodies in the world, for watching its population over a long session
+      struct BodyCounts
+      {
+         std::int64_t spawned = 0;     // Bodies added to the world (ever)
+         std::int64_t live = 0;        // Bodies in the world now
+         std::int64_t despawned = 0;   // Bodies destroyed (ever) because they left the kill volume
+         std::int64_t destroyed = 0;   // Bodies destroyed (ever), for any reason
+      };
+
+      // Contact events processed (ever), by type
+      struct ContactCounts
+      {
+         std::int64_t begin = 0;
+         std::int64_t end = 0;
+         std::int64_t impact = 0;
+      };
+
+      // Dynamic bodies whose position leaves the kill volume are destroyed.  The default is large enough to never matter.
+      explicit Simulation(const b2AABB& _kill_volume = { b2Vec2(-1.0e6f, -1.0e6f), b2Vec2(1.0e6f, 1.0e6f) });
+      // The contact listener and the world point at each other (and at the tables), so a simulation stays where it was made
+      Simulation(const Simulation&) = delete;
+      Simulation& operator=(const Simulation&) = delete;
+
+      // Create a new (empty) world with the gravity, destroying any previous world and its bodies and resetting the counts
+      void createWorld(b2Vec2 gravity);
+      // Destroy every body, keeping the world (and the memory of the tables, so bodies can be added again without allocating)
+      void clearBodies();
+      // Get the Box2D world (null until createWorld())
+      b2World* getWorld() { return world.get(); };
+      const b2World* getWorld() const { return world.get(); };
+
+      // Set the seconds of simulated time per step
+      void setTimeStep(float seconds);
+      float getTimeStep() const { return time_step; };
+      // Choose the solver iterations each step from how long the steps take, rather than always using VelocityIterations
+      // and PositionIterations (the default).  Opt in only: the steps then depend on the wall-clock, so runs are not repeatable.
+      void setAdaptiveIterations(bool _adaptive_iterations) { adaptive_iterations = _adaptive_iterations; iteration_controller.reset(); };
+      bool getAdaptiveIterations() const { return adaptive_iterations; };
+      // Destroy dynamic bodies as soon as they touch a static body
+      void setDestroyOnContact(bool _destroy_on_contact) { destroy_on_contact = _destroy_on_contact; };
+      bool getDestroyOnContact() const { return destroy_on_contact; };
+      // Destroy bodies spawned from prefabs this many seconds (of simulated time) after they spawn (BodyMetadata::Forever to keep them)
+      void setSpawnLifetime(float seconds) { spawn_lifetime = seconds; };
+      float getSpawnLifetime() const { return spawn_lifetime; };
+      // Set the kill volume (world coordinates)
+      void setKillVolume(const b2AABB& _kill_volume) { kill_volume = _kill_volume; };
+
+      // Add a new polygon to the world.  If dynamic_object is false the body is static (a fixed platform).
+      b2Body* addPolygon(float x_center_world, float y_center_world, const std::vector<buf::Vec2>& verts, bool dynamic_object);
+      // Add a new rectangle to the world.  If dynamic_object is false the body is static (a fixed platform).
+      b2Body* addRect(float x_center_world, float y_center_world, float width, float height, bool dynamic_object);
+      // Add a new circle to the world.  If dynamic_object is false the body is static (a fixed platform).
+      b2Body* addCircle(float x_center_world, float y_center_world, float radius, bool dynamic_object);
+      // Record a newly created body (after its fixtures are created) so it is classified, mirrored and drawn.  Returns its handle.
+      BodyHandle registerBody(b2Body* body, const BodyMetadata& metadata);
+      // Spawn a body from a prefab at the world coordinates.  Returns the new body.
+      b2Body* spawnPrefab(const PrefabRegistry& prefab_registry, PrefabHandle prefab, float x_world, float y_world);
+      // Spawn a body from the prefab at each world position.  Returns the number of bodies spawned.
+      std::size_t spawnMany(const PrefabRegistry& prefab_registry, PrefabHandle prefab, std::span<const b2Vec2> positions);
+      // Mark a body to be destroyed after the current step (safe to call at any time, including from Box2D callbacks)
+      void markForDestruction(b2Body* body);
+
+      // Step the world once, then handle its contact events, expired bodies and bodies out of the kill volume.  Returns the
+      // number of bodies destroyed.
+      std::size_t step();
+      // Return true if any (non-static) body is awake, i.e. it may still be moving
+      bool anyBodyAwake() const;
+      // Return the number of (non-static) bodies awake
+      std::int64_t awakeBodyCount() const;
+
+      // Get the counts of the bodies in the world
+      BodyCounts getBodyCounts() const { return { spawned_body_count, static_cast<std::int64_t>(body_metadata.size()), despawned_body_count, destroyed_body_count }; };
+      // Get the counts of the contact events processed
+      const ContactCounts& getContactCounts() const { return contact_counts; };
+      // Get the number of contacts in the world now (pairs of shapes whose bounding boxes overlap)
+      std::int32_t getContactCount() const { return world ? world->GetContactCount() : 0; };
+      // Get the gameplay data of every body (a body's handle is BodyMetadataTable::handleOf(body))
+      const BodyMetadataTable& getBodyMetadata() const { return body_metadata; };
+      // Get the shapes of every body
+      const ShapeRegistry& getShapeRegistry() const { return shape_registry; };
+      // Get the contiguous copy of every body's transform, refreshed after each step
+      const TransformMirror& getTransformMirror() const { return transform_mirror; };
+      // Get the listener recording the world's contact events
+      const ContactListener& getContactListener() const { return contact_listener; };
+      // Return a line describing the solver iterations being used (and how they were chosen)
+      std::string iterationsReport() const;
+
+   private:
+      friend class WorldSnapshot;   // Saves and restores the tables and counts along with the world
+
+      // Handle the contact events recorded during the last step (gameplay reactions to collisions go here)
+      void processContactEvents();
+      // Count down the lifetime of every body, and mark the bodies whose time is up for destruction
+      void expireBodies();
+      // Mark the dynamic bodies (awake or asleep) whose position is outside the kill volume for destruction.  Returns the number marked.
+      std::size_t despawnOutOfBounds();
+      // Destroy every body marked for destruction, as one batch.  Returns the number of bodies destroyed.
+      std::size_t destroyMarkedBodies();
+
+      float time_step{ DefaultTimeStep };
+      bool adaptive_iterations{ false };             // Choose the solver iterations each step (else always the fixed ones)
+      IterationController iteration_controller;      // Chooses the solver iterations, from the step times
+
+      ShapeRegistry shape_registry;                  // Shapes of every body (recorded when each body is added)
+      TransformMirror transform_mirror;              // Contiguous copy of every body's (current and previous) transform
+      BodyMetadataTable body_metadata;               // Gameplay data of every body, indexed by the handle in the body's user data
+
+      BodyDestructionQueue destruction_queue;        // Bodies to destroy after the current step
+      std::int64_t destroyed_body_count{ 0 };        // Bodies destroyed (ever)
+      std::int64_t spawned_body_count{ 0 };          // Bodies added to the world (ever)
+      std::int64_t despawned_body_count{ 0 };        // Bodies destroyed (ever) because they left the kill volume
+      b2AABB kill_volume;                            // Dynamic bodies outside this are destroyed
+      bool destroy_on_contact{ false };              // Destroy dynamic bodies as soon as they touch a static body
+      float spawn_lifetime{ BodyMetadata::Forever }; // Seconds a body spawned from a prefab lives
+
+      ContactListener contact_listener;              // Receives this world's collision callbacks
+      ContactCounts contact_counts;
+      std::unique_ptr<b2World> world;                // Declared last, so it is destroyed before what its bodies point to
+   };
+} // End namespace bolt::game_engine
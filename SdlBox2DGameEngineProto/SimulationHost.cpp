@@ -0,0 +1,34 @@
+
+#include "SimulationHost.h"
+
+#include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
+
+namespace bolt::game_engine
+{
+   // Purpose: Construct a host that steps its simulations on thread_count threads
+   SimulationHost::SimulationHost(std::size_t thread_count) : worker_pool(thread_count)
+   {
+      // On Windows b2Timer sets its (static) clock frequency the first time one is made, so make one before any worker 
+      // thread steps a world (which makes timers), rather than letting the first steps race to set it
+      const b2Timer timer;
+   }
+
+   // Purpose: Add a new simulation (with no world until its createWorld())
+   Simulation& SimulationHost::addSimulation(const b2AABB& kill_volume)
+   {
+      simulations.push_back(std::make_unique<Simulation>(kill_volume));
+      return *simulations.back();
+   }
+
+   // Purpose: Step every simulation step_count times, in parallel
+   //    Note: Each simulation takes all of its steps on one thread, so the threads only meet once per call (not once per step).
+   void SimulationHost::stepAll(std::int32_t step_count)
+   {
+      worker_pool.parallelFor(simulations.size(), [this, step_count](std::size_t index)
+      {
+         Simulation& simulation = *simulations[index];
+         for (std::int32_t step = 0; step < step_count; ++step)
+            simulation.step();
+      });
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,44 @@
+#pragma once
+// Purpose: Hosts any number of independent simulations (e.g. matches, or what-if rollouts) in one process, and steps them in
+//          parallel on a pool of worker threads.  Each simulation has its own world, contact listener and event queue, so the
+//          only things the threads share are the list of simulations and Box2D's global statistics counters (a benign race,
+//          see Simulation.h).
+//
+
+#include "bolt_buf.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace bolt::game_engine
+{
+   class SimulationHost
+   {
+   public:
+      // Step the simulations on thread_count threads (including the thread calling stepAll())
+      explicit SimulationHost(std::size_t thread_count);
+
+      // Add a new simulation (with no world until its createWorld()).  The reference stays valid for the life of the host.
+      Simulation& addSimulation(const b2AABB& kill_volume = { b2Vec2(-1.0e6f, -1.0e6f), b2Vec2(1.0e6f, 1.0e6f) });
+      // Destroy every simulation
+      void clear() { simulations.clear(); };
+      // Number of simulations
+      std::size_t size() const { return simulations.size(); };
+      // Get a simulation by its index (in the order they were added)
+      Simulation& operator[](std::size_t index) { return *simulations[index]; };
+      const Simulation& operator[](std::size_t index) const { return *simulations[index]; };
+      // Number of threads the simulations are stepped on
+      std::size_t threadCount() const { return worker_pool.threadCount(); };
+
+      // Step every simulation step_count times, in parallel (each simulation steps on one thread at a time).  Returns when
+      // they have all finished.
+      void stepAll(std::int32_t step_count = 1);
+
+   private:
+      std::vector<std::unique_ptr<Simulation>> simulations;   // Each simulation stays where it was made (see Simulation)
+      buf::WorkerPool worker_pool;
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,183 @@
+
+#include "TransformMirror.h"
+#include "bolt_buf_hash.h"
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+namespace bolt::game_engine
+{
+   // Purpose: Return the BodyFlags that currently describe the body
+   std::uint8_t TransformMirror::bodyFlags(const b2Body* body)
+   {
+      std::uint8_t flags = 0;
+      if (body->GetType() == b2_dynamicBody)
+         flags |= Dynamic;
+      if (body->IsAwake())
+         flags |= Awake;
+      return flags;
+   }
+
+   // Purpose: Add a row for a body.  Its shapes are shape_count entries in the ShapeRegistry starting at first_shape.
+   void TransformMirror::addBody(const b2Body* body, BodyHandle handle, std::uint32_t first_shape, std::uint32_t shape_count)
+   {
+      const b2Vec2& position = body->GetPosition();
+      const float angle = body->GetAngle();
+      const b2Vec2& velocity = body->GetLinearVelocity();
+
+      // A new body has not moved yet, so its previous transform is where it is now
+      if (handle >= handle_rows.size())
+         handle_rows.resize(handle + 1);
+      handle_rows[handle] = static_cast<std::uint32_t>(body_ptrs.size());
+
+      body_ptrs.push_back(body);
+      body_handles.push_back(handle);
+      x_positions.push_back(position.x);
+      y_positions.push_back(position.y);
+      angles.push_back(angle);
+      previous_x_positions.push_back(position.x);
+      previous_y_positions.push_back(position.y);
+      previous_angles.push_back(angle);
+      x_velocities.push_back(velocity.x);
+      y_velocities.push_back(velocity.y);
+      angular_velocities.push_back(body->GetAngularVelocity());
+      first_shapes.push_back(first_shape);
+      shape_counts.push_back(shape_count);
+      body_flags.push_back(bodyFlags(body));
+   }
+
+   // Purpose: Remove the rows of the bodies (call before the bodies are destroyed, after ShapeRegistry::removeBodies())
+   //    Compacts every array in one pass, moving the remaining rows down over the removed ones.
+   void TransformMirror::removeBodies(std::span<b2Body* const> sorted_bodies)
+   {
+      const std::size_t body_count = body_ptrs.size();
+      std::size_t write_index = 0;
+
+      for (std::size_t read_index = 0; read_index < body_count; ++read_index)
+      {
+         if (std::binary_search(sorted_bodies.begin(), sorted_bodies.end(), body_ptrs[read_index], std::less<const b2Body*>{}))
+            continue;   // Removed
+
+         if (write_index != read_index)
+         {
+            body_ptrs[write_index] = body_ptrs[read_index];
+            body_handles[write_index] = body_handles[read_index];
+            x_positions[write_index] = x_positions[read_index];
+            y_positions[write_index] = y_positions[read_index];
+            angles[write_index] = angles[read_index];
+            previous_x_positions[write_index] = previous_x_positions[read_index];
+            previous_y_positions[write_index] = previous_y_positions[read_index];
+            previous_angles[write_index] = previous_angles[read_index];
+            x_velocities[write_index] = x_velocities[read_index];
+            y_velocities[write_index] = y_velocities[read_index];
+            angular_velocities[write_index] = angular_velocities[read_index];
+            shape_counts[write_index] = shape_counts[read_index];
+            body_flags[write_index] = body_flags[read_index];
+            handle_rows[body_handles[write_index]] = static_cast<std::uint32_t>(write_index);
+         }
+         ++write_index;
+      }
+
+      body_ptrs.resize(write_index);
+      body_handles.resize(write_index);
+      x_positions.resize(write_index);
+      y_positions.resize(write_index);
+      angles.resize(write_index);
+      previous_x_positions.resize(write_index);
+      previous_y_positions.resize(write_index);
+      previous_angles.resize(write_index);
+      x_velocities.resize(write_index);
+      y_velocities.resize(write_index);
+      angular_velocities.resize(write_index);
+      first_shapes.resize(write_index);
+      shape_counts.resize(write_index);
+      body_flags.resize(write_index);
+
+      // The ShapeRegistry removed the same bodies' shapes and kept the rest in order, so each body's shapes now start 
+      // right after the shapes of the body before it
+      std::uint32_t first_shape = 0;
+      for (std::size_t index = 0; index < write_index; ++index)
+      {
+         first_shapes[index] = first_shape;
+         first_shape += shape_counts[index];
+      }
+   }
+
+   // Purpose: Copy the transform and velocity of every body from Box2D.  Call once after each physics step.
+   void TransformMirror::refresh()
+   {
+      // The current transforms become the previous ones (swapping just exchanges the vectors' buffers, nothing is copied)
+      std::swap(x_positions, previous_x_positions);
+      std::swap(y_positions, previous_y_positions);
+      std::swap(angles, previous_angles);
+
+      const std::size_t body_count = body_ptrs.size();
+      for (std::size_t index = 0; index < body_count; ++index)
+      {
+         const b2Body* body = body_ptrs[index];
+         const b2Vec2& position = body->GetPosition();
+         x_positions[index] = position.x;
+         y_positions[index] = position.y;
+         angles[index] = body->GetAngle();
+         const b2Vec2& velocity = body->GetLinearVelocity();
+         x_velocities[index] = velocity.x;
+         y_velocities[index] = velocity.y;
+         angular_velocities[index] = body->GetAngularVelocity();
+         body_flags[index] = bodyFlags(body);
+      }
+   }
+
+   // Purpose: Return a 64-bit hash of every body's position, angle and velocity, as of the last refresh()
+   //    Each array is hashed in turn (with SIMD, straight through its memory), chained by seeding each with the hash so far.
+   //    The flags are not hashed: whether a body is asleep follows from how it has been moving.
+   std::uint64_t TransformMirror::stateHash() const
+   {
+      std::uint64_t hash = buf::hashMix64(body_ptrs.size());
+      for (const std::vector<float>* values : { &x_positions, &y_positions, &angles, &x_velocities, &y_velocities, &angular_velocities })
+         hash = buf::hashFloats(*values, hash);
+      return hash;
+   }
+
+   // Purpose: Forget all bodies
+   void TransformMirror::clear()
+   {
+      body_ptrs.clear();
+      body_handles.clear();
+      x_positions.clear();
+      y_positions.clear();
+      angles.clear();
+      previous_x_positions.clear();
+      previous_y_positions.clear();
+      previous_angles.clear();
+      x_velocities.clear();
+      y_velocities.clear();
+      angular_velocities.clear();
+      first_shapes.clear();
+      shape_counts.clear();
+      body_flags.clear();
+      handle_rows.clear();
+   }
+
+   // Purpose: Make room for body_count more bodies, with handles below handle_count (e.g. before adding many bodies at once)
+   void TransformMirror::reserve(std::size_t body_count, std::size_t handle_count)
+   {
+      handle_rows.reserve(handle_count);   // So addBody() grows it without reallocating
+
+      const std::size_t capacity = body_ptrs.size() + body_count;
+      body_ptrs.reserve(capacity);
+      body_handles.reserve(capacity);
+      x_positions.reserve(capacity);
+      y_positions.reserve(capacity);
+      angles.reserve(capacity);
+      previous_x_positions.reserve(capacity);
+      previous_y_positions.reserve(capacity);
+      previous_angles.reserve(capacity);
+      x_velocities.reserve(capacity);
+      y_velocities.reserve(capacity);
+      angular_velocities.reserve(capacity);
+      first_shapes.reserve(capacity);
+      shape_counts.reserve(capacity);
+      body_flags.reserve(capacity);
+   }
+} // End namespace bolt::game_engine
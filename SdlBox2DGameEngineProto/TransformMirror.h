@@ -0,0 +1,89 @@
+#pragma once
+// Purpose: A contiguous (structure of arrays) copy of the transform of every body in the world, refreshed once after each 
+//          physics step.  Render, culling and queries stream through these arrays in order, rather than walking Box2D's 
+//          (heap scattered) linked list of bodies and reading each body's transform through a pointer.  Each body's 
+//          velocity is copied too, so the whole state of the bodies can be hashed (see stateHash()) without touching Box2D.
+//
+
+#include "BodyMetadata.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   class TransformMirror
+   {
+   public:
+      // Bit flags describing a body (see flags())
+      enum BodyFlags : std::uint8_t 
+      { 
+         Dynamic = 1 << 0,    // Moved by the physics (not a static or kinematic body)
+         Awake = 1 << 1,      // Not sleeping, so may have moved in the last step
+      };
+
+      // Add a row for a body.  Its shapes are shape_count entries in the ShapeRegistry starting at first_shape.
+      void addBody(const b2Body* body, BodyHandle handle, std::uint32_t first_shape, std::uint32_t shape_count);
+      // Remove the rows of the bodies (call before the bodies are destroyed, after ShapeRegistry::removeBodies()).  The bodies
+      // must be sorted by address.  The remaining rows keep their order.
+      void removeBodies(std::span<b2Body* const> sorted_bodies);
+      // Copy the transform and velocity of every body from Box2D.  Call once after each physics step.  The transforms from before the 
+      // step are kept as the previous transforms (for interpolating between steps).
+      void refresh();
+      // Forget all bodies
+      void clear();
+      // Make room for body_count more bodies, with handles below handle_count (e.g. before adding many bodies at once)
+      void reserve(std::size_t body_count, std::size_t handle_count);
+
+      // Number of bodies (rows)
+      std::size_t size() const { return body_ptrs.size(); };
+      // Return the row of the body with the handle (the body must have been added)
+      std::uint32_t rowOf(BodyHandle handle) const { return handle_rows[handle]; };
+
+      //// Each array has one entry (row) per body, in the order the bodies were added.
+      std::span<const b2Body* const> bodies() const { return body_ptrs; };
+      std::span<const BodyHandle> handles() const { return body_handles; };        // The body's entry in the BodyMetadataTable
+      std::span<const float> x() const { return x_positions; };
+      std::span<const float> y() const { return y_positions; };
+      std::span<const float> angle() const { return angles; };
+      std::span<const float> previousX() const { return previous_x_positions; };
+      std::span<const float> previousY() const { return previous_y_positions; };
+      std::span<const float> previousAngle() const { return previous_angles; };
+      std::span<const float> velocityX() const { return x_velocities; };            // Meters per second
+      std::span<const float> velocityY() const { return y_velocities; };            // Meters per second
+      std::span<const float> angularVelocity() const { return angular_velocities; };  // Radians per second
+      std::span<const std::uint32_t> firstShape() const { return first_shapes; };  // Index of the body's first shape in the ShapeRegistry
+      std::span<const std::uint32_t> shapeCount() const { return shape_counts; };  // Number of shapes the body has in the ShapeRegistry
+      std::span<const std::uint8_t> flags() const { return body_flags; };         // BodyFlags
+
+      // Return a 64-bit hash of every body's position, angle and velocity (the bits of each, in row order), as of the last
+      // refresh().  Two worlds stepped the same way from the same state have the same hash, so comparing hashes catches a 
+      // simulation that has drifted from another (a desync) on the step it happens.  Cheap (SIMD, a fraction of a 
+      // nanosecond per value), so it can be done after every step.
+      std::uint64_t stateHash() const;
+
+   private:
+      // Return the BodyFlags that currently describe the body
+      static std::uint8_t bodyFlags(const b2Body* body);
+
+      std::vector<const b2Body*> body_ptrs;
+      std::vector<BodyHandle> body_handles;
+      std::vector<float> x_positions;
+      std::vector<float> y_positions;
+      std::vector<float> angles;              // Radians
+      std::vector<float> previous_x_positions;
+      std::vector<float> previous_y_positions;
+      std::vector<float> previous_angles;
+      std::vector<float> x_velocities;
+      std::vector<float> y_velocities;
+      std::vector<float> angular_velocities;
+      std::vector<std::uint32_t> first_shapes;
+      std::vector<std::uint32_t> shape_counts;
+      std::vector<std::uint8_t> body_flags;
+
+      std::vector<std::uint32_t> handle_rows;   // Row of each body, indexed by its handle (the reverse of body_handles)
+   };
+} // End namespace bolt::game_engine
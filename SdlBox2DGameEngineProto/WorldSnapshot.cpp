@@ -0,0 +1,518 @@
+
+#include "WorldSnapshot.h"
+#include "bolt_buf.h"
+
+#include <Box2D/Box2D.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <format>
+#include <type_traits>
+
+#include "bolt_util_debug_macros.h" // Should be last include and ONLY in *.cpp files
+
+using namespace std::string_literals;
+
+namespace bolt::game_engine
+{
+   using namespace buf;
+
+   namespace
+   {
+      //// Layout of the blob: a SnapshotHeader, the free handles of the body metadata table, then a BodyRecord for each body
+      //   (in transform mirror order), each followed by a FixtureRecord (and the shape's points) for each of its fixtures.
+      //   The records have no padding (so the blob has no uninitialized bytes) and are copied with memcpy (so need no alignment).
+
+      struct SnapshotHeader
+      {
+         std::uint32_t magic;
+         std::uint32_t version;
+         std::uint32_t body_count;
+         std::uint32_t metadata_capacity;     // BodyMetadataTable::capacity()
+         std::uint32_t free_handle_count;
+         b2Vec2 gravity;
+         std::uint32_t unused;
+         std::int64_t spawned_body_count;
+         std::int64_t despawned_body_count;
+         std::int64_t destroyed_body_count;
+         std::int64_t contact_begin_count;
+         std::int64_t contact_end_count;
+         std::int64_t contact_impact_count;
+      };
+      static_assert(sizeof(SnapshotHeader) == 80);
+
+      // BodyRecord::body_flags
+      enum BodyRecordFlags : std::uint8_t
+      {
+         Awake = 1 << 0,
+         SleepingAllowed = 1 << 1,
+         Bullet = 1 << 2,
+         FixedRotation = 1 << 3,
+         Enabled = 1 << 4,
+      };
+
+      struct BodyRecord
+      {
+         BodyHandle handle;
+         float lifetime;                 // BodyMetadata
+         b2Vec2 position;
+         float angle;
+         b2Vec2 linear_velocity;
+         float angular_velocity;
+         float linear_damping;
+         float angular_damping;
+         float gravity_scale;
+         b2MassData mass_data;
+         std::uint8_t type;              // b2BodyType
+         std::uint8_t body_flags;        // BodyRecordFlags
+         std::uint8_t fixture_count;
+         std::uint8_t kind;              // BodyMetadata
+         std::uint8_t team;
+         std::uint8_t render_style;
+         std::uint8_t metadata_flags;
+         std::uint8_t unused;
+      };
+      static_assert(sizeof(BodyRecord) == 68);
+
+      // Followed by the polygon's centroid, vertices and normals (b2Vec2 each), or the circle's center
+      struct FixtureRecord
+      {
+         float density;
+         float friction;
+         float restitution;
+         float radius;                   // b2Shape::m_radius (the polygon skin, or the circle's radius)
+         std::uint16_t category_bits;
+         std::uint16_t mask_bits;
+         std::int16_t group_index;
+         std::uint8_t shape_type;        // b2Shape::Type
+         std::uint8_t is_sensor;
+         std::uint8_t vertex_count;      // Polygon only
+         std::uint8_t unused[3];
+      };
+      static_assert(sizeof(FixtureRecord) == 28);
+
+      // Purpose: Append the bytes of count values to the blob
+      template <typename T>
+      void append(std::vector<std::byte>& blob, const T* values, std::size_t count = 1)
+      {
+         static_assert(std::is_trivially_copyable_v<T>);
+         const std::size_t offset = blob.size();
+         blob.resize(offset + sizeof(T) * count);
+         std::memcpy(blob.data() + offset, values, sizeof(T) * count);
+      }
+
+      // Reads values from a blob in order, failing (rather than reading past the end) if the blob is too short
+      class BlobReader
+      {
+      public:
+         explicit BlobReader(std::span<const std::byte> _bytes) : bytes(_bytes) {};
+
+         // Copy the next count values into values.  Returns false if the blob is too short.
+         template <typename T>
+         bool read(T* values, std::size_t count = 1)
+         {
+            static_assert(std::is_trivially_copyable_v<T>);
+            if (bytes.size() - offset < sizeof(T) * count)
+               return false;
+
+            std::memcpy(values, bytes.data() + offset, sizeof(T) * count);
+            offset += sizeof(T) * count;
+            return true;
+         }
+
+         // Skip the next count values.  Returns false if the blob is too short.
+         template <typename T>
+         bool skip(std::size_t count = 1)
+         {
+            if (bytes.size() - offset < sizeof(T) * count)
+               return false;
+
+            offset += sizeof(T) * count;
+            return true;
+         }
+
+         // Return true if every byte has been read
+         bool atEnd() const { return offset == bytes.size(); };
+         // Return the number of bytes read (or skipped) so far
+         std::size_t position() const { return offset; };
+
+      private:
+         std::span<const std::byte> bytes;
+         std::size_t offset = 0;
+      };
+
+      // Handle states, while validating
+      enum HandleState : std::uint8_t { Unseen, Free, Used };
+
+      constexpr std::uint8_t AllBodyRecordFlags = Awake | SleepingAllowed | Bullet | FixedRotation | Enabled;
+
+      // Purpose: Check the whole blob is a snapshot this version can restore (before anything is changed), returning its header
+      //    Everything restore() hands to the body metadata table is checked here (as the table only asserts): each handle is in
+      //    the table, used once (by one body, or as one free handle), and every handle but InvalidBodyHandle is one or the 
+      //    other.  The enums are checked to be in range.  handle_states is scratch memory (kept, so validating does not allocate).
+      Result<SnapshotHeader> validate(std::span<const std::byte> bytes, std::vector<std::uint8_t>& handle_states)
+      {
+         BlobReader reader(bytes);
+
+         SnapshotHeader header;
+         if (!reader.read(&header) || header.magic != WorldSnapshot::Magic)
+            return buf::unexpected("Not a world snapshot."s);
+         if (header.version != WorldSnapshot::Version)
+            return buf::unexpected(std::format("World snapshot version {} cannot be restored (expected version {}).", header.version, WorldSnapshot::Version));
+
+         // Every handle (but InvalidBodyHandle) is a body or free.  Checked before the capacity is trusted (to size handle_states).
+         const std::uint64_t record_count = std::uint64_t{ header.body_count } + header.free_handle_count;
+         if (header.metadata_capacity < 1 || record_count != header.metadata_capacity - 1u || header.body_count > bytes.size() / sizeof(BodyRecord) ||
+            header.free_handle_count > bytes.size() / sizeof(BodyHandle))
+         {
+            return buf::unexpected("The world snapshot is damaged (bad body metadata table)."s);
+         }
+         handle_states.assign(header.metadata_capacity, Unseen);
+
+         for (std::uint32_t free_index = 0; free_index < header.free_handle_count; ++free_index)
+         {
+            BodyHandle free_handle;
+            if (!reader.read(&free_handle) || free_handle == InvalidBodyHandle || free_handle >= header.metadata_capacity || handle_states[free_handle] != Unseen)
+               return buf::unexpected(std::format("The world snapshot is damaged (free handle {}).", free_index));
+            handle_states[free_handle] = Free;
+         }
+
+         for (std::uint32_t body_index = 0; body_index < header.body_count; ++body_index)
+         {
+            BodyRecord body_record;
+            if (!reader.read(&body_record) || body_record.handle == InvalidBodyHandle || body_record.handle >= header.metadata_capacity || 
+               handle_states[body_record.handle] != Unseen)
+            {
+               return buf::unexpected(std::format("The world snapshot is damaged (body {} handle).", body_index));
+            }
+            handle_states[body_record.handle] = Used;
+
+            if (body_record.type > b2_dynamicBody || (body_record.body_flags & ~AllBodyRecordFlags) != 0 || 
+               body_record.kind > static_cast<std::uint8_t>(BodyKind::Dynamic) || body_record.render_style > static_cast<std::uint8_t>(RenderStyle::Ball) ||
+               (body_record.metadata_flags & ~BodyMetadata::MarkedForDestruction) != 0)
+            {
+               return buf::unexpected(std::format("The world snapshot is damaged (body {} type, kind, style or flags).", body_index));
+            }
+
+            for (std::uint8_t fixture_index = 0; fixture_index < body_record.fixture_count; ++fixture_index)
+            {
+               FixtureRecord fixture_record;
+               if (!reader.read(&fixture_record))
+                  return buf::unexpected(std::format("The world snapshot is damaged (body {} fixture {}).", body_index, fixture_index));
+
+               bool valid = false;
+               if (fixture_record.shape_type == b2Shape::e_polygon)
+                  valid = fixture_record.vertex_count >= 3 && fixture_record.vertex_count <= b2_maxPolygonVertices && reader.skip<b2Vec2>(1 + 2 * fixture_record.vertex_count);
+               else if (fixture_record.shape_type == b2Shape::e_circle)
+                  valid = reader.skip<b2Vec2>();
+
+               if (!valid)
+                  return buf::unexpected(std::format("The world snapshot is damaged (body {} fixture {} shape).", body_index, fixture_index));
+            }
+         }
+
+         if (!reader.atEnd())
+            return buf::unexpected("The world snapshot is damaged (extra bytes at the end)."s);
+
+         return header;
+      }
+   }
+
+   // Purpose: Save the state of the simulation's world (replacing anything saved before)
+   Result<void> WorldSnapshot::capture(const Simulation& simulation)
+   {
+      const b2World* world = simulation.getWorld();
+      if (world == nullptr)
+         return buf::unexpected("The simulation has no world to capture."s);
+
+      const TransformMirror& transform_mirror = simulation.transform_mirror;
+      const BodyMetadataTable& body_metadata = simulation.body_metadata;
+      const auto free_handles = body_metadata.freeHandles();
+
+      blob.clear();   // Keeps its memory, so capturing a world of the same size again does not allocate
+
+      SnapshotHeader header{};
+      header.magic = Magic;
+      header.version = Version;
+      header.body_count = static_cast<std::uint32_t>(transform_mirror.size());
+      header.metadata_capacity = static_cast<std::uint32_t>(body_metadata.capacity());
+      header.free_handle_count = static_cast<std::uint32_t>(free_handles.size());
+      header.gravity = world->GetGravity();
+      header.spawned_body_count = simulation.spawned_body_count;
+      header.despawned_body_count = simulation.despawned_body_count;
+      header.destroyed_body_count = simulation.destroyed_body_count;
+      header.contact_begin_count = simulation.contact_counts.begin;
+      header.contact_end_count = simulation.contact_counts.end;
+      header.contact_impact_count = simulation.contact_counts.impact;
+      append(blob, &header);
+      append(blob, free_handles.data(), free_handles.size());
+
+      // Bodies in transform mirror order.  That is the order they were created in, so creating them in this order again also
+      // rebuilds Box2D's body list in the same order.
+      const auto bodies = transform_mirror.bodies();
+      const auto handles = transform_mirror.handles();
+      for (std::size_t row = 0; row < bodies.size(); ++row)
+      {
+         const b2Body* body = bodies[row];
+         const BodyMetadata& metadata = body_metadata[handles[row]];
+
+         // Box2D adds each new fixture to the front of the body's list, so they are saved last first (the order they were created)
+         fixtures.clear();
+         for (const b2Fixture* fixture = body->GetFixtureList(); fixture != nullptr; fixture = fixture->GetNext())
+            fixtures.push_back(fixture);
+         if (fixtures.size() > 255)
+         {
+            blob.clear();   // A failed capture leaves the snapshot empty (not part of a world)
+            return buf::unexpected(std::format("Body {} has too many fixtures ({}) to capture.", handles[row], fixtures.size()));
+         }
+
+         BodyRecord body_record{};
+         body_record.handle = handles[row];
+         body_record.lifetime = metadata.lifetime;
+         body_record.position = body->GetPosition();
+         body_record.angle = body->GetAngle();
+         body_record.linear_velocity = body->GetLinearVelocity();
+         body_record.angular_velocity = body->GetAngularVelocity();
+         body_record.linear_damping = body->GetLinearDamping();
+         body_record.angular_damping = body->GetAngularDamping();
+         body_record.gravity_scale = body->GetGravityScale();
+         body->GetMassData(&body_record.mass_data);
+         body_record.type = static_cast<std::uint8_t>(body->GetType());
+         body_record.body_flags = (body->IsAwake() ? Awake : 0) | (body->IsSleepingAllowed() ? SleepingAllowed : 0) | (body->IsBullet() ? Bullet : 0) |
+            (body->IsFixedRotation() ? FixedRotation : 0) | (body->IsEnabled() ? Enabled : 0);
+         body_record.fixture_count = static_cast<std::uint8_t>(fixtures.size());
+         body_record.kind = static_cast<std::uint8_t>(metadata.kind);
+         body_record.team = metadata.team;
+         body_record.render_style = static_cast<std::uint8_t>(metadata.render_style);
+         body_record.metadata_flags = metadata.flags;
+         append(blob, &body_record);
+
+         for (auto fixture_iter = fixtures.rbegin(); fixture_iter != fixtures.rend(); ++fixture_iter)
+         {
+            const b2Fixture* fixture = *fixture_iter;
+            const b2Shape* shape = fixture->GetShape();
+            const b2Filter& filter = fixture->GetFilterData();
+
+            FixtureRecord fixture_record{};
+            fixture_record.density = fixture->GetDensity();
+            fixture_record.friction = fixture->GetFriction();
+            fixture_record.restitution = fixture->GetRestitution();
+            fixture_record.radius = shape->m_radius;
+            fixture_record.category_bits = filter.categoryBits;
+            fixture_record.mask_bits = filter.maskBits;
+            fixture_record.group_index = filter.groupIndex;
+            fixture_record.shape_type = static_cast<std::uint8_t>(shape->GetType());
+            fixture_record.is_sensor = fixture->IsSensor() ? 1 : 0;
+
+            switch (shape->GetType())
+            {
+            case b2Shape::e_polygon:
+            {
+               const auto* polygon = static_cast<const b2PolygonShape*>(shape);
+               fixture_record.vertex_count = static_cast<std::uint8_t>(polygon->m_count);
+               append(blob, &fixture_record);
+               append(blob, &polygon->m_centroid);
+               append(blob, polygon->m_vertices, polygon->m_count);
+               append(blob, polygon->m_normals, polygon->m_count);
+               break;
+            }
+            case b2Shape::e_circle:
+               append(blob, &fixture_record);
+               append(blob, &static_cast<const b2CircleShape*>(shape)->m_p);
+               break;
+            default:
+               blob.clear();   // A failed capture leaves the snapshot empty (not part of a world)
+               return buf::unexpected(std::format("Body {} has a shape (type {}) that cannot be captured.", handles[row], static_cast<int>(shape->GetType())));
+            }
+         }
+      }
+
+      return Result<void>{};
+   }
+
+   // Purpose: Replace the simulation's bodies with the saved ones
+   //    Note: Each shape is copied back as it was saved, so Box2D does not compute its convex hull (and normals) again.  Each
+   //          fixture is created with no density and the body's saved mass set once, so the mass is not computed again either.
+   Result<void> WorldSnapshot::restore(Simulation& simulation) const
+   {
+      b2World* world = simulation.getWorld();
+      if (world == nullptr)
+         return buf::unexpected("The simulation has no world to restore into."s);
+
+      auto header_result = validate(blob, handle_states);
+      if (!header_result)
+         return buf::unexpected(header_result.error());
+      const SnapshotHeader& header = *header_result;
+
+      simulation.clearBodies();
+      world->SetGravity(header.gravity);
+
+      BlobReader reader(blob);
+      reader.skip<SnapshotHeader>();
+
+      // The metadata table is rebuilt with the same free handles, so bodies spawned after the restore get the same handles
+      // they got after the capture
+      simulation.body_metadata.reset(header.metadata_capacity);
+      for (std::uint32_t free_index = 0; free_index < header.free_handle_count; ++free_index)
+      {
+         BodyHandle free_handle;
+         reader.read(&free_handle);
+         simulation.body_metadata.addFreeHandle(free_handle);
+      }
+
+      simulation.shape_registry.reserve(header.body_count);
+      simulation.transform_mirror.reserve(header.body_count, header.metadata_capacity);
+
+      for (std::uint32_t body_index = 0; body_index < header.body_count; ++body_index)
+      {
+         BodyRecord body_record;
+         reader.read(&body_record);
+
+         b2BodyDef bodydef;
+         bodydef.type = static_cast<b2BodyType>(body_record.type);
+         bodydef.position = body_record.position;
+         bodydef.angle = body_record.angle;
+         bodydef.angularVelocity = body_record.angular_velocity;
+         bodydef.linearDamping = body_record.linear_damping;
+         bodydef.angularDamping = body_record.angular_damping;
+         bodydef.gravityScale = body_record.gravity_scale;
+         bodydef.awake = (body_record.body_flags & Awake) != 0;
+         bodydef.allowSleep = (body_record.body_flags & SleepingAllowed) != 0;
+         bodydef.bullet = (body_record.body_flags & Bullet) != 0;
+         bodydef.fixedRotation = (body_record.body_flags & FixedRotation) != 0;
+         bodydef.enabled = (body_record.body_flags & Enabled) != 0;
+
+         b2Body* body = world->CreateBody(&bodydef);
+
+         for (std::uint8_t fixture_index = 0; fixture_index < body_record.fixture_count; ++fixture_index)
+         {
+            FixtureRecord fixture_record;
+            reader.read(&fixture_record);
+
+            b2FixtureDef fixture_def;
+            fixture_def.density = 0.0f;   // The body's mass is set once, below
+            fixture_def.friction = fixture_record.friction;
+            fixture_def.restitution = fixture_record.restitution;
+            fixture_def.isSensor = fixture_record.is_sensor != 0;
+            fixture_def.filter.categoryBits = fixture_record.category_bits;
+            fixture_def.filter.maskBits = fixture_record.mask_bits;
+            fixture_def.filter.groupIndex = fixture_record.group_index;
+
+            b2PolygonShape polygon;
+            b2CircleShape circle;
+            if (fixture_record.shape_type == b2Shape::e_polygon)
+            {
+               polygon.m_radius = fixture_record.radius;
+               polygon.m_count = fixture_record.vertex_count;
+               reader.read(&polygon.m_centroid);
+               reader.read(polygon.m_vertices, polygon.m_count);
+               reader.read(polygon.m_normals, polygon.m_count);
+               fixture_def.shape = &polygon;
+            }
+            else
+            {
+               circle.m_radius = fixture_record.radius;
+               reader.read(&circle.m_p);
+               fixture_def.shape = &circle;
+            }
+
+            body->CreateFixture(&fixture_def)->SetDensity(fixture_record.density);
+         }
+
+         // Setting the mass moves the center of mass, which changes the linear velocity (of the center of mass), so the
+         // velocity is set after the mass.  A sleeping body has no velocity, so setting it does not wake the body.
+         if (bodydef.type == b2_dynamicBody)
+            body->SetMassData(&body_record.mass_data);
+         body->SetLinearVelocity(body_record.linear_velocity);
+
+         BodyMetadata metadata;
+         metadata.lifetime = body_record.lifetime;
+         metadata.kind = static_cast<BodyKind>(body_record.kind);
+         metadata.team = body_record.team;
+         metadata.render_style = static_cast<RenderStyle>(body_record.render_style);
+         metadata.flags = body_record.metadata_flags & ~BodyMetadata::MarkedForDestruction;
+         simulation.body_metadata.addAt(body_record.handle, body, metadata);
+
+         const auto first_shape = static_cast<std::uint32_t>(simulation.shape_registry.shapes().size());
+         simulation.shape_registry.addBody(body);
+         const auto shape_count = static_cast<std::uint32_t>(simulation.shape_registry.shapes().size()) - first_shape;
+         simulation.transform_mirror.addBody(body, body_record.handle, first_shape, shape_count);
+
+         // Bodies that were going to be destroyed after the next step still are
+         if (body_record.metadata_flags & BodyMetadata::MarkedForDestruction)
+            simulation.markForDestruction(body);
+      }
+
+      simulation.spawned_body_count = header.spawned_body_count;
+      simulation.despawned_body_count = header.despawned_body_count;
+      simulation.destroyed_body_count = header.destroyed_body_count;
+      simulation.contact_counts = { header.contact_begin_count, header.contact_end_count, header.contact_impact_count };
+
+      return Result<void>{};
+   }
+
+   // Purpose: Check that this snapshot saved the same world as another, returning an error describing the first difference
+   //    Every byte must match, except each body's rotational inertia: Box2D keeps it about the center of mass and returns it
+   //    about the body's origin, so a restored body's inertia can differ from the saved one by rounding (relative_tolerance).
+   Result<void> WorldSnapshot::compare(const WorldSnapshot& other, float relative_tolerance) const
+   {
+      auto header_result = validate(blob, handle_states);
+      if (!header_result)
+         return buf::unexpected(header_result.error());
+      if (auto other_result = validate(other.blob, handle_states); !other_result)
+         return buf::unexpected(std::format("The other snapshot: {}", other_result.error()));
+
+      const std::size_t free_handles_end = sizeof(SnapshotHeader) + header_result->free_handle_count * sizeof(BodyHandle);
+      if (other.blob.size() < free_handles_end || std::memcmp(blob.data(), other.blob.data(), free_handles_end) != 0)
+         return buf::unexpected("The snapshots differ in their header or free handles."s);
+
+      BlobReader reader(blob);
+      BlobReader other_reader(other.blob);
+      reader.skip<std::byte>(free_handles_end);
+      other_reader.skip<std::byte>(free_handles_end);
+
+      // Purpose: Skip a body's fixtures (already validated)
+      auto skipFixtures = [](BlobReader& fixture_reader, std::uint8_t fixture_count)
+      {
+         for (std::uint8_t fixture_index = 0; fixture_index < fixture_count; ++fixture_index)
+         {
+            FixtureRecord fixture_record;
+            fixture_reader.read(&fixture_record);
+            fixture_reader.skip<b2Vec2>((fixture_record.shape_type == b2Shape::e_polygon) ? 1 + 2 * fixture_record.vertex_count : 1);
+         }
+      };
+
+      for (std::uint32_t body_index = 0; body_index < header_result->body_count; ++body_index)
+      {
+         BodyRecord body_record;
+         BodyRecord other_body_record;
+         reader.read(&body_record);
+         other_reader.read(&other_body_record);
+
+         const float inertia = body_record.mass_data.I;
+         const float other_inertia = other_body_record.mass_data.I;
+         if (std::abs(inertia - other_inertia) > relative_tolerance * std::max({ 1.0f, std::abs(inertia), std::abs(other_inertia) }))
+            return buf::unexpected(std::format("Body {} differs in its rotational inertia ({}, not {}).", body_index, inertia, other_inertia));
+
+         body_record.mass_data.I = 0.0f;
+         other_body_record.mass_data.I = 0.0f;
+         if (std::memcmp(&body_record, &other_body_record, sizeof(BodyRecord)) != 0)
+            return buf::unexpected(std::format("Body {} (handle {}) differs.", body_index, body_record.handle));
+
+         // The fixtures (with their shapes) are compared byte for byte
+         const std::size_t fixtures_start = reader.position();
+         const std::size_t other_fixtures_start = other_reader.position();
+         skipFixtures(reader, body_record.fixture_count);
+         skipFixtures(other_reader, other_body_record.fixture_count);
+         const std::size_t fixtures_size = reader.position() - fixtures_start;
+         if (fixtures_size != other_reader.position() - other_fixtures_start || 
+            std::memcmp(blob.data() + fixtures_start, other.blob.data() + other_fixtures_start, fixtures_size) != 0)
+         {
+            return buf::unexpected(std::format("Body {} (handle {}) differs in its fixtures.", body_index, body_record.handle));
+         }
+      }
+
+      return Result<void>{};
+   }
+} // End namespace bolt::game_engine
@@ -0,0 +1,61 @@
+#pragma once
+// Purpose: Saves the state of a Simulation's world (its bodies and their fixtures, velocities and sleep state, with the body
+//          metadata and counts) to a compact binary blob, and restores it.  Restoring is much faster than building the scene
+//          again: shapes are copied back as they were (no convex hull or mass calculations), and the world, the tables and
+//          the blob keep their memory, so a restore (once the memory has grown to fit) does not allocate.
+//
+//    Limitations (of what Box2D lets us set):
+//       - Contacts are not saved.  Box2D finds them again in the first step after a restore, starting the solver cold
+//         (without the last step's impulses), so that step may differ slightly from the step that followed the capture.
+//       - Each body's sleep timer (how long it has been still) is not saved, so an awake body that was about to fall
+//         asleep stays awake for up to half a second more.
+//       - Only the bodies added through the Simulation are saved (not bodies added directly to its b2World), and only
+//         polygon and circle shapes (the only shapes the engine makes).  Joints are not saved.
+//
+
+#include "bolt_buf.h"
+#include "Simulation.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <Box2D/Box2D.h>
+
+namespace bolt::game_engine
+{
+   class WorldSnapshot
+   {
+   public:
+      static constexpr std::uint32_t Magic = 0x31535742;   // "BWS1" at the start of every blob
+      static constexpr std::uint32_t Version = 1;          // Changes when the layout of the blob changes
+
+      // Save the state of the simulation's world (replacing anything saved before).  Returns an error if the world has
+      // something that cannot be saved.  Call between steps (not from a Box2D callback).
+      buf::Result<void> capture(const Simulation& simulation);
+      // Replace the simulation's bodies with the saved ones.  The simulation's world must exist (it is kept, with its
+      // settings).  Returns an error if the blob is not a valid snapshot (the whole blob is checked before anything is changed).
+      buf::Result<void> restore(Simulation& simulation) const;
+      // Check that this snapshot saved the same world as another (e.g. a capture straight after a restore).  Returns an error
+      // describing the first difference: every byte must match, except each body's rotational inertia, which Box2D recomputes
+      // and so may differ by rounding (within relative_tolerance).
+      buf::Result<void> compare(const WorldSnapshot& other, float relative_tolerance) const;
+
+      // The saved blob (e.g. to write to a file)
+      std::span<const std::byte> bytes() const { return blob; };
+      // Load a blob saved by bytes() (checked by restore())
+      void assign(std::span<const std::byte> _bytes) { blob.assign(_bytes.begin(), _bytes.end()); };
+      // Number of bytes in the blob
+      std::size_t size() const { return blob.size(); };
+      // Return true if nothing has been saved
+      bool empty() const { return blob.empty(); };
+      // Forget the saved state
+      void clear() { blob.clear(); };
+
+   private:
+      std::vector<std::byte> blob;
+      std::vector<const b2Fixture*> fixtures;   // Scratch: one body's fixtures, while capturing
+      mutable std::vector<std::uint8_t> handle_states;   // Scratch: what each handle is, while validating (kept, so restoring does not allocate)
+   };
+} // End namespace bolt::game_engine
@@ -0,0 +1,60 @@
+#pragma once
+// Purpose: Box2D's user settings (included by box2d/b2_settings.h when B2_USER_SETTINGS is defined).  The same as Box2D 2.4's
+//          defaults, except that b2Alloc() and b2Free() go through buf::countedMalloc() and buf::countedFree(), so the 
+//          benchmarks count Box2D's allocations (its block allocator's chunks, contact and body arrays etc.) along with the 
+//          engine's.
+//    Note: Only the Benchmark configuration defines B2_USER_SETTINGS, and it must link a Box2D built with the same settings:
+//          configure Box2D with -DBOX2D_USER_SETTINGS=ON (which defines B2_USER_SETTINGS) and this directory on its include 
+//          path, and build it to %BoltBox2DRoot%\build-user-settings.  Defining B2_USER_SETTINGS against a stock Box2D would 
+//          give the program two different b2Alloc() and b2Free() (the library's and these), so the other configurations don't.
+//
+
+#include "bolt_buf_allocation_counter.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+
+// Tunable Constants (Box2D's defaults)
+#define b2_lengthUnitsPerMeter 1.0f
+#define b2_maxPolygonVertices 8
+
+// User data (Box2D's defaults: the engine stores a BodyHandle in b2BodyUserData::pointer)
+struct B2_API b2BodyUserData
+{
+   b2BodyUserData() { pointer = 0; }
+   uintptr_t pointer;
+};
+
+struct B2_API b2FixtureUserData
+{
+   b2FixtureUserData() { pointer = 0; }
+   uintptr_t pointer;
+};
+
+struct B2_API b2JointUserData
+{
+   b2JointUserData() { pointer = 0; }
+   uintptr_t pointer;
+};
+
+// Memory allocation: counted
+inline void* b2Alloc(int32 size)
+{
+   return buf::countedMalloc(static_cast<std::size_t>(size));
+}
+
+inline void b2Free(void* mem)
+{
+   buf::countedFree(mem);
+}
+
+// Logging (Box2D's default)
+B2_API void b2Log_Default(const char* string, va_list args);
+
+inline void b2Log(const char* string, ...)
+{
+   va_list args;
+   va_start(args, string);
+   b2Log_Default(string, args);
+   va_end(args);
+}
@@ -4,6 +4,13 @@
 #include "bolt_buf_result.h"
 #include "bolt_buf_matrix.h"
 #include "bolt_buf_matrix_print.h"
+#include "bolt_buf_process.h"
+#include "bolt_buf_allocation_counter.h"
+#include "bolt_buf_ring_buffer.h"
+#include "bolt_buf_worker_pool.h"
+#include "bolt_buf_hash.h"
+#include "bolt_buf_profile.h"
+#include "bolt_buf_trace.h"
 
 using namespace buf::matrix_print;
 
@@ -0,0 +1,93 @@
+
+#include "bolt_buf_allocation_counter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+   std::atomic<std::uint64_t> allocation_count{ 0 };
+   std::atomic<std::uint64_t> deallocation_count{ 0 };
+   std::atomic<std::uint64_t> allocated_bytes{ 0 };
+   std::atomic<std::uint64_t> malloc_allocation_count{ 0 };
+
+   // Purpose: Count an allocation of size bytes
+   //    Note: Relaxed atomics, since only the totals matter (not their order relative to anything else).
+   inline void countAllocation(std::size_t size)
+   {
+      if constexpr (buf::AllocationCountingEnabled)
+      {
+         allocation_count.fetch_add(1, std::memory_order_relaxed);
+         allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+      }
+   }
+
+   // Purpose: Count a deallocation
+   inline void countDeallocation()
+   {
+      if constexpr (buf::AllocationCountingEnabled)
+         deallocation_count.fetch_add(1, std::memory_order_relaxed);
+   }
+}
+
+// Purpose: Return the allocations counted so far (all zero unless built with BOLT_COUNT_ALLOCATIONS)
+buf::AllocationCounts buf::allocationCounts()
+{
+   return { allocation_count.load(std::memory_order_relaxed), deallocation_count.load(std::memory_order_relaxed), 
+      allocated_bytes.load(std::memory_order_relaxed), malloc_allocation_count.load(std::memory_order_relaxed) };
+}
+
+// Purpose: malloc(), counted
+void* buf::countedMalloc(std::size_t size)
+{
+   countAllocation(size);
+   if constexpr (AllocationCountingEnabled)
+      malloc_allocation_count.fetch_add(1, std::memory_order_relaxed);
+   return std::malloc(size);
+}
+
+// Purpose: free(), counted
+void buf::countedFree(void* memory)
+{
+   if (memory == nullptr)
+      return;
+
+   countDeallocation();
+   std::free(memory);
+}
+
+#ifdef BOLT_COUNT_ALLOCATIONS
+// Replacements for the global operator new and delete that count each call.  The other forms (arrays, nothrow) call these.
+//    Like the standard operator new, a failed allocation calls the new handler (which may free some memory) and tries again,
+//    and only throws once there is no handler.
+void* operator new(std::size_t size)
+{
+   countAllocation(size);
+
+   for (;;)
+   {
+      if (void* memory = std::malloc(size == 0 ? 1 : size))
+         return memory;
+
+      std::new_handler handler = std::get_new_handler();
+      if (handler == nullptr)
+         throw std::bad_alloc{};
+      handler();
+   }
+}
+
+void operator delete(void* memory) noexcept
+{
+   if (memory == nullptr)
+      return;
+
+   countDeallocation();
+   std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+   operator delete(memory);
+}
+#endif
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// buf: Namespace for Bolton Utility Functions
+//    Counts of heap allocations, for benchmarks: calls to the global operator new and delete (which are replaced with counting
+//    versions), and to countedMalloc() and countedFree() (which Box2D's b2Alloc() and b2Free() call, see b2_user_settings.h).
+//    Only counted when built with BOLT_COUNT_ALLOCATIONS defined (the Benchmark configuration), since counting adds atomic 
+//    adds (shared by every thread) to each allocation.  Otherwise the global operator new and delete are left alone, and the 
+//    counts stay zero.
+namespace buf
+{
+#ifdef BOLT_COUNT_ALLOCATIONS
+   constexpr bool AllocationCountingEnabled = true;
+#else
+   constexpr bool AllocationCountingEnabled = false;
+#endif
+
+   struct AllocationCounts
+   {
+      std::uint64_t allocations = 0;          // Calls to operator new and countedMalloc()
+      std::uint64_t deallocations = 0;        // Calls to operator delete and countedFree() (of a non-null pointer)
+      std::uint64_t bytes = 0;                // Bytes asked for
+      std::uint64_t malloc_allocations = 0;   // Of the allocations, calls to countedMalloc() (e.g. from Box2D)
+   };
+
+   // Return the allocations counted so far (all zero unless built with BOLT_COUNT_ALLOCATIONS).  
+   //    Note: Subtract two readings to get the allocations made between them.
+   AllocationCounts allocationCounts();
+
+   // malloc() and free(), counted (for libraries that let their allocator be replaced, e.g. Box2D's b2Alloc() and b2Free())
+   void* countedMalloc(std::size_t size);
+   void countedFree(void* memory);
+
+   inline AllocationCounts operator-(const AllocationCounts& lhs, const AllocationCounts& rhs)
+   {
+      return { lhs.allocations - rhs.allocations, lhs.deallocations - rhs.deallocations, lhs.bytes - rhs.bytes, lhs.malloc_allocations - rhs.malloc_allocations };
+   }
+}
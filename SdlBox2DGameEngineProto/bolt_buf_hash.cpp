@@ -0,0 +1,140 @@
+#include "bolt_buf_hash.h"
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+// SIMD instruction set used by the hash
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BUF_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+   //// The floats are hashed in blocks of four (two 64-bit lanes), each lane mixed with a key that changes from block to block
+   //   (so the hash depends on where each float is, not just its value).  The same method as XXH3's accumulate step.
+   constexpr std::size_t FloatsPerBlock = 4;
+   constexpr std::uint64_t KeyLow = 0xbe4ba423396cfeb8ull;     // Key of lane 0 for the first block
+   constexpr std::uint64_t KeyHigh = 0x1cad21f72c81017cull;    // Key of lane 1 for the first block
+   constexpr std::uint64_t KeyStep = 0x9e3779b97f4a7c15ull;    // Added to both keys for each block
+   constexpr std::uint64_t SeedMix = 0xc2b2ae3d27d4eb4full;
+
+   // Purpose: Add one block (two 64-bit lanes of float bits) to the accumulators
+   inline void accumulateBlock(std::array<std::uint64_t, 2>& accumulators, std::uint64_t lane_0, std::uint64_t lane_1, std::uint64_t block_index)
+   {
+      const std::uint64_t data_key_0 = lane_0 ^ (KeyLow + block_index * KeyStep);
+      const std::uint64_t data_key_1 = lane_1 ^ (KeyHigh + block_index * KeyStep);
+      accumulators[0] += lane_1 + (data_key_0 & 0xffffffffull) * (data_key_0 >> 32);
+      accumulators[1] += lane_0 + (data_key_1 & 0xffffffffull) * (data_key_1 >> 32);
+   }
+
+   // Purpose: Add the last (partial) block of floats to the accumulators, padded with zero bits
+   void accumulateTail(std::array<std::uint64_t, 2>& accumulators, std::span<const float> tail, std::uint64_t block_index)
+   {
+      std::array<std::uint32_t, FloatsPerBlock> bits{};
+      for (std::size_t index = 0; index < tail.size(); ++index)
+         bits[index] = std::bit_cast<std::uint32_t>(tail[index]);
+
+      accumulateBlock(accumulators, bits[0] | (std::uint64_t{ bits[1] } << 32), bits[2] | (std::uint64_t{ bits[3] } << 32), block_index);
+   }
+
+   // Purpose: The accumulators before the first block
+   std::array<std::uint64_t, 2> startAccumulators(std::uint64_t seed)
+   {
+      return { seed ^ SeedMix, buf::hashMix64(seed + SeedMix) };
+   }
+
+   // Purpose: Combine the accumulators (and the number of floats, so trailing zeros change the hash) into the hash
+   std::uint64_t finishHash(const std::array<std::uint64_t, 2>& accumulators, std::size_t count)
+   {
+      return buf::hashMix64(buf::hashMix64(accumulators[0] + count) ^ accumulators[1]);
+   }
+}
+
+
+// Purpose: Mix the bits of a 64-bit value (so every input bit affects every output bit)
+//    The SplitMix64 finalizer.
+std::uint64_t buf::hashMix64(std::uint64_t value)
+{
+   value ^= value >> 30;
+   value *= 0xbf58476d1ce4e5b9ull;
+   value ^= value >> 27;
+   value *= 0x94d049bb133111ebull;
+   value ^= value >> 31;
+   return value;
+}
+
+// Purpose: Hash the floats, using only scalar code (the reference for the SIMD version)
+std::uint64_t buf::hashFloatsScalar(std::span<const float> values, std::uint64_t seed)
+{
+   std::array<std::uint64_t, 2> accumulators = startAccumulators(seed);
+
+   const std::size_t full_blocks = values.size() / FloatsPerBlock;
+   for (std::size_t block = 0; block < full_blocks; ++block)
+   {
+      std::array<std::uint32_t, FloatsPerBlock> bits;
+      std::memcpy(bits.data(), values.data() + block * FloatsPerBlock, sizeof(bits));
+      accumulateBlock(accumulators, bits[0] | (std::uint64_t{ bits[1] } << 32), bits[2] | (std::uint64_t{ bits[3] } << 32), block);
+   }
+
+   if (values.size() % FloatsPerBlock != 0)
+      accumulateTail(accumulators, values.subspan(full_blocks * FloatsPerBlock), full_blocks);
+
+   return finishHash(accumulators, values.size());
+}
+
+// Purpose: Hash the floats
+//    SSE2 adds a whole block (both lanes) at once: _mm_mul_epu32 multiplies the low and high halves of each lane, and the
+//    keys of both lanes step together.  Gives exactly the same hash as hashFloatsScalar().
+std::uint64_t buf::hashFloats(std::span<const float> values, std::uint64_t seed)
+{
+#ifdef BUF_SIMD_SSE2
+   std::array<std::uint64_t, 2> accumulators = startAccumulators(seed);
+
+   const std::size_t full_blocks = values.size() / FloatsPerBlock;
+   __m128i accumulator = _mm_set_epi64x(static_cast<long long>(accumulators[1]), static_cast<long long>(accumulators[0]));
+   __m128i key = _mm_set_epi64x(static_cast<long long>(KeyHigh), static_cast<long long>(KeyLow));
+   const __m128i key_step = _mm_set1_epi64x(static_cast<long long>(KeyStep));
+
+   // Add a block's product (and the block, lanes swapped) to the accumulator, then step the key
+   auto accumulate = [&key_step](__m128i& accumulator, __m128i& key, const float* block_values)
+   {
+      const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block_values));
+      const __m128i data_key = _mm_xor_si128(data, key);
+      const __m128i data_key_high = _mm_shuffle_epi32(data_key, _MM_SHUFFLE(0, 3, 0, 1));   // High half of each lane, moved to the low half
+      const __m128i product = _mm_mul_epu32(data_key, data_key_high);
+      const __m128i data_swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));        // Each lane is added to the other's accumulator
+      accumulator = _mm_add_epi64(accumulator, _mm_add_epi64(data_swapped, product));
+      key = _mm_add_epi64(key, key_step);
+   };
+
+   // Two blocks per iteration, into separate accumulators (each with its own key), so they do not wait on each other.  The 
+   // accumulators are sums, so adding them together at the end gives the same result as one accumulator.
+   std::size_t block = 0;
+   if (full_blocks >= 2)
+   {
+      __m128i accumulator_odd = _mm_setzero_si128();
+      __m128i key_odd = _mm_add_epi64(key, key_step);
+      const float* block_values = values.data();
+      for (; block + 2 <= full_blocks; block += 2, block_values += 2 * FloatsPerBlock)
+      {
+         accumulate(accumulator, key, block_values);
+         key = _mm_add_epi64(key, key_step);
+         accumulate(accumulator_odd, key_odd, block_values + FloatsPerBlock);
+         key_odd = _mm_add_epi64(key_odd, key_step);
+      }
+      accumulator = _mm_add_epi64(accumulator, accumulator_odd);
+   }
+   if (block < full_blocks)
+      accumulate(accumulator, key, values.data() + block * FloatsPerBlock);
+   _mm_storeu_si128(reinterpret_cast<__m128i*>(accumulators.data()), accumulator);
+
+   if (values.size() % FloatsPerBlock != 0)
+      accumulateTail(accumulators, values.subspan(full_blocks * FloatsPerBlock), full_blocks);
+
+   return finishHash(accumulators, values.size());
+#else
+   return hashFloatsScalar(values, seed);
+#endif
+}
@@ -0,0 +1,21 @@
+#pragma once
+// Purpose: Fast 64-bit hashes of arrays of floats, for comparing simulation states (e.g. to catch two machines that should
+//          be stepping the same world drifting apart).  Not a cryptographic hash.
+//
+//    The hash is of the bits of the floats (so 0.0 and -0.0 hash differently, and a NaN hashes as its bits), and gives the
+//    same result on every platform and with or without SIMD.
+//
+
+#include <cstdint>
+#include <span>
+
+namespace buf
+{
+   // Hash the floats (SIMD: SSE2, with a scalar fallback for other targets).  Chain hashes of several arrays by passing the
+   // hash of one as the seed of the next.  The hash depends on the order of the floats, not just their values.
+   std::uint64_t hashFloats(std::span<const float> values, std::uint64_t seed = 0);
+   // Same as hashFloats(), using only scalar code (the reference for the SIMD version)
+   std::uint64_t hashFloatsScalar(std::span<const float> values, std::uint64_t seed = 0);
+   // Mix the bits of a 64-bit value (so every input bit affects every output bit).  Also used to combine hashes.
+   std::uint64_t hashMix64(std::uint64_t value);
+}
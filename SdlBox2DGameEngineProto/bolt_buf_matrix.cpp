@@ -1,24 +1,291 @@
 #include "bolt_buf_matrix.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
 
-// @@ TODO: JAB: Write calculateCentroid()
-// Purpose: Calculate centroid from a set of (polygon) points 
-buf::Vec2 buf::calculateCentroid(const std::vector<buf::Vec2>& points)
+// SIMD instruction sets used by the batch transforms
+#if defined(__AVX2__)
+#define BUF_SIMD_AVX2
+#define BUF_SIMD_SSE2
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BUF_SIMD_SSE2
+#include <emmintrin.h>
+#endif
+
+
+// Purpose: Calculate centroid (center of area) from a set of (polygon) points 
+//    Sums the area weighted centroid of the triangle fan from the first point.  The points are made relative to the first point 
+//    first, so polygons far from the origin do not lose precision.  A clockwise polygon has a negative area, which cancels out.
+buf::Vec2 buf::calculateCentroid(std::span<const buf::Vec2> points)
 {
-   using namespace std::string_literals;
-   throw std::logic_error("Function not yet implemented: "s + __func__);
+   if (points.empty())
+      return buf::Vec2(0, 0);
+
+   const buf::Vec2 origin = points[0];
+
+   float twice_area = 0.0f;            // Twice the signed area of the polygon
+   float centroid_x_sum = 0.0f;        // Sum of (triangle centroid * 3) * (twice triangle area)
+   float centroid_y_sum = 0.0f;
+   float max_distance_squared = 0.0f;  // Size of the polygon, to decide if the area is too small to use
+
+   for (std::size_t index = 1; index + 1 < points.size(); ++index)
+   {
+      const buf::Vec2 a = points[index] - origin;
+      const buf::Vec2 b = points[index + 1] - origin;
+      const float cross = a.x * b.y - b.x * a.y;
+
+      twice_area += cross;
+      centroid_x_sum += (a.x + b.x) * cross;
+      centroid_y_sum += (a.y + b.y) * cross;
+      max_distance_squared = std::max(max_distance_squared, a.x * a.x + a.y * a.y);
+   }
+   if (points.size() > 1)
+   {
+      const buf::Vec2 last = points.back() - origin;
+      max_distance_squared = std::max(max_distance_squared, last.x * last.x + last.y * last.y);
+   }
 
-   return buf::Vec2(0, 0);
+   // No (meaningful) area, e.g. a single point or the points are in a line, so use the average of the points
+   constexpr float degenerate_area_ratio = 1.0e-6f;
+   if (std::abs(twice_area) <= degenerate_area_ratio * max_distance_squared || twice_area == 0.0f)
+   {
+      buf::Vec2 sum(0, 0);
+      for (const auto& point : points)
+         sum += point - origin;
+      return origin + sum / static_cast<float>(points.size());
+   }
+
+   return origin + buf::Vec2(centroid_x_sum, centroid_y_sum) / (3.0f * twice_area);
 }
 
-// @@ TODO: JAB: Write orientToCentroid()
 // Purpose: Calculate the centroid of the points and adjust the points to orient at the centroid.  Return the offset. 
-buf::Vec2 buf::orientToCentroid(std::vector<buf::Vec2>& points)
+//    Note: Add the returned offset to where the points were placed to keep them in the same place.
+buf::Vec2 buf::orientToCentroid(std::span<buf::Vec2> points)
+{
+   const buf::Vec2 centroid = calculateCentroid(points);
+
+   for (auto& point : points)
+      point -= centroid;
+
+   return centroid;
+}
+
+// Purpose: Calculate the centroid of many polygons.  Polygon i is points[point_offsets[i]] up to (but not including) points[point_offsets[i + 1]]
+void buf::calculateCentroidsBatch(std::span<const buf::Vec2> points, std::span<const std::uint32_t> point_offsets, std::span<buf::Vec2> centroids)
+{
+   assert(!point_offsets.empty() && centroids.size() >= point_offsets.size() - 1);
+
+   for (std::size_t polygon = 0; polygon + 1 < point_offsets.size(); ++polygon)
+      centroids[polygon] = calculateCentroid(points.subspan(point_offsets[polygon], point_offsets[polygon + 1] - point_offsets[polygon]));
+}
+
+
+//// Batch transforms ////
+
+namespace
+{
+   // sin(x) for x in [-pi/2, pi/2]: Taylor series to x^11 (error under 1e-7 over the range)
+   constexpr float SinC3 = -1.0f / 6.0f;
+   constexpr float SinC5 = 1.0f / 120.0f;
+   constexpr float SinC7 = -1.0f / 5040.0f;
+   constexpr float SinC9 = 1.0f / 362880.0f;
+   constexpr float SinC11 = -1.0f / 39916800.0f;
+
+   constexpr float Pi = 3.14159265358979f;
+   constexpr float HalfPi = 1.57079632679490f;
+   // 2 pi split in two (Cody-Waite), so wrapping large angles does not lose precision: TwoPiHigh has few enough bits that
+   // multiplying it by a whole number of turns is exact.
+   constexpr float TwoPiHigh = 6.28125f;
+   constexpr float TwoPiLow = 1.93530717958647692e-3f;
+   constexpr float InvTwoPi = 0.159154943091895f;
+
+   // Purpose: Scalar version of the SIMD sine/cosine (used for any angles left over after the SIMD loop)
+   //    The angle is wrapped into [-pi, pi], then folded into [-pi/2, pi/2] where the polynomial is accurate:
+   //       sin(a) = sin(pi - a) and cos(a) = sin(pi/2 - |a|)
+   inline void sinCosPoly(float angle, float& sin_out, float& cos_out)
+   {
+      const float turns = std::nearbyint(angle * InvTwoPi);
+      const float wrapped = (angle - turns * TwoPiHigh) - turns * TwoPiLow;
+      const float abs_wrapped = std::abs(wrapped);
+      const float sin_arg = (abs_wrapped > HalfPi) ? std::copysign(Pi, wrapped) - wrapped : wrapped;
+      const float cos_arg = HalfPi - abs_wrapped;
+
+      auto sin_poly = [](float x) 
+      { 
+         const float x2 = x * x; 
+         return x + x * x2 * (SinC3 + x2 * (SinC5 + x2 * (SinC7 + x2 * (SinC9 + x2 * SinC11))));
+      };
+      sin_out = sin_poly(sin_arg);
+      cos_out = sin_poly(cos_arg);
+   }
+
+#ifdef BUF_SIMD_SSE2
+   // Purpose: Four sines and cosines at once (same method as sinCosPoly())
+   inline void sinCosSse2(__m128 angle, __m128& sin_out, __m128& cos_out)
+   {
+      const __m128 sign_mask = _mm_set1_ps(-0.0f);
+
+      // Wrap into [-pi, pi].  Note: _mm_cvtps_epi32 rounds to nearest (the default rounding mode)
+      const __m128 turns = _mm_cvtepi32_ps(_mm_cvtps_epi32(_mm_mul_ps(angle, _mm_set1_ps(InvTwoPi))));
+      const __m128 wrapped = _mm_sub_ps(_mm_sub_ps(angle, _mm_mul_ps(turns, _mm_set1_ps(TwoPiHigh))), _mm_mul_ps(turns, _mm_set1_ps(TwoPiLow)));
+
+      const __m128 sign = _mm_and_ps(wrapped, sign_mask);
+      const __m128 abs_wrapped = _mm_andnot_ps(sign_mask, wrapped);
+
+      // Fold the sine argument into [-pi/2, pi/2]
+      const __m128 fold_mask = _mm_cmpgt_ps(abs_wrapped, _mm_set1_ps(HalfPi));
+      const __m128 folded = _mm_sub_ps(_mm_or_ps(_mm_set1_ps(Pi), sign), wrapped);
+      const __m128 sin_arg = _mm_or_ps(_mm_and_ps(fold_mask, folded), _mm_andnot_ps(fold_mask, wrapped));
+      const __m128 cos_arg = _mm_sub_ps(_mm_set1_ps(HalfPi), abs_wrapped);
+
+      auto sin_poly = [](__m128 x)
+      {
+         const __m128 x2 = _mm_mul_ps(x, x);
+         __m128 poly = _mm_add_ps(_mm_set1_ps(SinC9), _mm_mul_ps(x2, _mm_set1_ps(SinC11)));
+         poly = _mm_add_ps(_mm_set1_ps(SinC7), _mm_mul_ps(x2, poly));
+         poly = _mm_add_ps(_mm_set1_ps(SinC5), _mm_mul_ps(x2, poly));
+         poly = _mm_add_ps(_mm_set1_ps(SinC3), _mm_mul_ps(x2, poly));
+         return _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), poly));
+      };
+      sin_out = sin_poly(sin_arg);
+      cos_out = sin_poly(cos_arg);
+   }
+#endif
+
+#ifdef BUF_SIMD_AVX2
+   // Purpose: Eight sines and cosines at once (same method as sinCosPoly())
+   inline void sinCosAvx2(__m256 angle, __m256& sin_out, __m256& cos_out)
+   {
+      const __m256 sign_mask = _mm256_set1_ps(-0.0f);
+
+      // Wrap into [-pi, pi]
+      const __m256 turns = _mm256_round_ps(_mm256_mul_ps(angle, _mm256_set1_ps(InvTwoPi)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const __m256 wrapped = _mm256_sub_ps(_mm256_sub_ps(angle, _mm256_mul_ps(turns, _mm256_set1_ps(TwoPiHigh))), _mm256_mul_ps(turns, _mm256_set1_ps(TwoPiLow)));
+
+      const __m256 sign = _mm256_and_ps(wrapped, sign_mask);
+      const __m256 abs_wrapped = _mm256_andnot_ps(sign_mask, wrapped);
+
+      // Fold the sine argument into [-pi/2, pi/2]
+      const __m256 fold_mask = _mm256_cmp_ps(abs_wrapped, _mm256_set1_ps(HalfPi), _CMP_GT_OQ);
+      const __m256 folded = _mm256_sub_ps(_mm256_or_ps(_mm256_set1_ps(Pi), sign), wrapped);
+      const __m256 sin_arg = _mm256_blendv_ps(wrapped, folded, fold_mask);
+      const __m256 cos_arg = _mm256_sub_ps(_mm256_set1_ps(HalfPi), abs_wrapped);
+
+      auto sin_poly = [](__m256 x)
+      {
+         const __m256 x2 = _mm256_mul_ps(x, x);
+         __m256 poly = _mm256_add_ps(_mm256_set1_ps(SinC9), _mm256_mul_ps(x2, _mm256_set1_ps(SinC11)));
+         poly = _mm256_add_ps(_mm256_set1_ps(SinC7), _mm256_mul_ps(x2, poly));
+         poly = _mm256_add_ps(_mm256_set1_ps(SinC5), _mm256_mul_ps(x2, poly));
+         poly = _mm256_add_ps(_mm256_set1_ps(SinC3), _mm256_mul_ps(x2, poly));
+         return _mm256_add_ps(x, _mm256_mul_ps(_mm256_mul_ps(x, x2), poly));
+      };
+      sin_out = sin_poly(sin_arg);
+      cos_out = sin_poly(cos_arg);
+   }
+#endif
+}
+
+// Purpose: Calculate the sine and cosine of every angle (radians)
+void buf::sinCosBatch(std::span<const float> angles, std::span<float> sin_out, std::span<float> cos_out)
+{
+   assert(sin_out.size() >= angles.size() && cos_out.size() >= angles.size());
+
+   const std::size_t count = angles.size();
+   std::size_t index = 0;
+
+#if defined(BUF_SIMD_AVX2)
+   for (; index + 8 <= count; index += 8)
+   {
+      __m256 sin_values, cos_values;
+      sinCosAvx2(_mm256_loadu_ps(&angles[index]), sin_values, cos_values);
+      _mm256_storeu_ps(&sin_out[index], sin_values);
+      _mm256_storeu_ps(&cos_out[index], cos_values);
+   }
+#endif
+#if defined(BUF_SIMD_SSE2)
+   for (; index + 4 <= count; index += 4)
+   {
+      __m128 sin_values, cos_values;
+      sinCosSse2(_mm_loadu_ps(&angles[index]), sin_values, cos_values);
+      _mm_storeu_ps(&sin_out[index], sin_values);
+      _mm_storeu_ps(&cos_out[index], cos_values);
+   }
+#endif
+   for (; index < count; ++index)
+      sinCosPoly(angles[index], sin_out[index], cos_out[index]);
+}
+
+// Purpose: Transform the points of many bodies from body (local) coordinates to world coordinates
+//    Works through the bodies in blocks, so the sines and cosines of a block fit in a (stack) buffer and nothing is allocated.
+void buf::transformPointsBatch(std::span<const buf::Vec2> local_points, std::span<const std::uint32_t> point_offsets,
+   std::span<const float> x, std::span<const float> y, std::span<const float> angles, std::span<buf::Vec2> world_points)
 {
-   using namespace std::string_literals;
-   throw std::logic_error("Function not yet implemented: "s + __func__);
+   const std::size_t body_count = angles.size();
+   assert(point_offsets.size() == body_count + 1 && x.size() == body_count && y.size() == body_count);
+   assert(world_points.size() >= local_points.size() && point_offsets[body_count] <= local_points.size());
+
+   constexpr std::size_t BlockSize = 256;
+   std::array<float, BlockSize> sin_block;
+   std::array<float, BlockSize> cos_block;
+
+   for (std::size_t block_start = 0; block_start < body_count; block_start += BlockSize)
+   {
+      const std::size_t block_count = std::min(BlockSize, body_count - block_start);
+      sinCosBatch(angles.subspan(block_start, block_count), sin_block, cos_block);
+
+      for (std::size_t block_index = 0; block_index < block_count; ++block_index)
+      {
+         const std::size_t body = block_start + block_index;
+         const float sin_angle = sin_block[block_index];
+         const float cos_angle = cos_block[block_index];
 
-   return buf::Vec2(0, 0);
+         std::uint32_t point = point_offsets[body];
+         const std::uint32_t point_end = point_offsets[body + 1];
+
+#ifdef BUF_SIMD_SSE2
+         // Two points at a time: [x0, y0, x1, y1] * [c, c, c, c] + [y0, x0, y1, x1] * [-s, s, -s, s] + [bx, by, bx, by]
+         const __m128 cos_4 = _mm_set1_ps(cos_angle);
+         const __m128 sin_4 = _mm_setr_ps(-sin_angle, sin_angle, -sin_angle, sin_angle);
+         const __m128 translate_4 = _mm_setr_ps(x[body], y[body], x[body], y[body]);
+
+         for (; point + 2 <= point_end; point += 2)
+         {
+            const __m128 local = _mm_loadu_ps(&local_points[point].x);
+            const __m128 swapped = _mm_shuffle_ps(local, local, _MM_SHUFFLE(2, 3, 0, 1));
+            const __m128 world = _mm_add_ps(_mm_add_ps(_mm_mul_ps(local, cos_4), _mm_mul_ps(swapped, sin_4)), translate_4);
+            _mm_storeu_ps(&world_points[point].x, world);
+         }
+#endif
+         for (; point < point_end; ++point)
+         {
+            const buf::Vec2& local = local_points[point];
+            world_points[point] = { cos_angle * local.x - sin_angle * local.y + x[body], sin_angle * local.x + cos_angle * local.y + y[body] };
+         }
+      }
+   }
 }
 
+// Purpose: Same as transformPointsBatch(), using only scalar code and std::sin()/std::cos() (the reference for the SIMD version)
+void buf::transformPointsBatchScalar(std::span<const buf::Vec2> local_points, std::span<const std::uint32_t> point_offsets,
+   std::span<const float> x, std::span<const float> y, std::span<const float> angles, std::span<buf::Vec2> world_points)
+{
+   const std::size_t body_count = angles.size();
+   assert(point_offsets.size() == body_count + 1 && x.size() == body_count && y.size() == body_count);
+   assert(world_points.size() >= local_points.size() && point_offsets[body_count] <= local_points.size());
+
+   for (std::size_t body = 0; body < body_count; ++body)
+   {
+      const float sin_angle = std::sin(angles[body]);
+      const float cos_angle = std::cos(angles[body]);
+
+      for (std::uint32_t point = point_offsets[body]; point < point_offsets[body + 1]; ++point)
+      {
+         const buf::Vec2& local = local_points[point];
+         world_points[point] = { cos_angle * local.x - sin_angle * local.y + x[body], sin_angle * local.x + cos_angle * local.y + y[body] };
+      }
+   }
+}
 
@@ -57,6 +57,7 @@
 #include <cassert>
 #include <span>
 #include <vector>
+#include <cstdint>
 
 // buf: Namespace for Bolton Utility Functions
 namespace buf
@@ -93,11 +94,33 @@ namespace buf
 
    // Make a span (i.e. a non-memory-owning container) of points given a pointer to a b2Vec2 and a count (as per Box2D data formats)
    inline std::span<buf::Vec2> makeVec2Span(b2Vec2* points, int32 count) { return { reinterpret_cast<buf::Vec2 *> (points) , static_cast<size_t> (count)}; };
-
-   // Calculate centroid from a set of (polygon) points 
-   buf::Vec2 calculateCentroid(const std::vector<buf::Vec2>& points);
+   inline std::span<const buf::Vec2> makeVec2Span(const b2Vec2* points, int32 count) { return { reinterpret_cast<const buf::Vec2 *> (points) , static_cast<size_t> (count)}; };
+
+   //// Batch transforms (SIMD: AVX2 when compiled with /arch:AVX2, otherwise SSE2, with a scalar fallback for other targets)
+   // Calculate the sine and cosine of every angle (radians).  Accurate to about 1e-6 for angles up to several thousand radians.
+   void sinCosBatch(std::span<const float> angles, std::span<float> sin_out, std::span<float> cos_out);
+
+   // Transform the points of many bodies from body (local) coordinates to world coordinates: rotate by the body's angle
+   // (radians) then translate by the body's (x, y). 
+   //    local_points:  The points of every body packed one body after another.
+   //    point_offsets: Body i's points are local_points[point_offsets[i]] up to (but not including) local_points[point_offsets[i + 1]],
+   //                   so there is one more offset than there are bodies.
+   //    x, y, angles:  The world position and rotation of each body.
+   //    world_points:  Output, the same size as local_points.
+   void transformPointsBatch(std::span<const buf::Vec2> local_points, std::span<const std::uint32_t> point_offsets, 
+      std::span<const float> x, std::span<const float> y, std::span<const float> angles, std::span<buf::Vec2> world_points);
+   // Same as transformPointsBatch(), using only scalar code and std::sin()/std::cos() (the reference for the SIMD version)
+   void transformPointsBatchScalar(std::span<const buf::Vec2> local_points, std::span<const std::uint32_t> point_offsets,
+      std::span<const float> x, std::span<const float> y, std::span<const float> angles, std::span<buf::Vec2> world_points);
+
+   //// Polygon centroids (the points may be in clockwise or counter-clockwise order; nothing is allocated)
+   // Calculate centroid (center of area) from a set of (polygon) points.  If the polygon has no area (e.g. the points are in a line)
+   // the average of the points is returned instead.
+   buf::Vec2 calculateCentroid(std::span<const buf::Vec2> points);
    // Calculate the centroid of the points and adjust the points to orient at the centroid.  Return the offset. 
-   buf::Vec2 orientToCentroid (std::vector<buf::Vec2>& points);
+   buf::Vec2 orientToCentroid (std::span<buf::Vec2> points);
+   // Calculate the centroid of many polygons.  Polygon i is points[point_offsets[i]] up to (but not including) points[point_offsets[i + 1]]
+   void calculateCentroidsBatch(std::span<const buf::Vec2> points, std::span<const std::uint32_t> point_offsets, std::span<buf::Vec2> centroids);
 }
 
 
@@ -0,0 +1,68 @@
+
+#include "bolt_buf_process.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include <fstream>
+#endif
+
+// Purpose: Return the CPU time (user + system, in seconds) used by this process so far.
+//    Note: std::clock() is not used because on Windows it measures wall-clock time, not CPU time.
+double buf::processCpuSeconds()
+{
+#ifdef _WIN32
+   FILETIME creation_time, exit_time, kernel_time, user_time;
+   if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time))
+      return 0.0;
+
+   // FILETIME is in 100 nanosecond units
+   auto to_seconds = [](const FILETIME& file_time) { return ((static_cast<unsigned long long>(file_time.dwHighDateTime) << 32) | file_time.dwLowDateTime) * 1.0e-7; };
+   return to_seconds(kernel_time) + to_seconds(user_time);
+#else
+   timespec cpu_time{};
+   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpu_time);
+   return cpu_time.tv_sec + cpu_time.tv_nsec * 1.0e-9;
+#endif
+}
+
+// Purpose: Return the most physical memory (resident set / working set, in bytes) this process has used at once so far
+std::size_t buf::processPeakResidentBytes()
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS memory_counters{};
+   if (!GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters, sizeof(memory_counters)))
+      return 0;
+   return memory_counters.PeakWorkingSetSize;
+#else
+   rusage usage{};
+   getrusage(RUSAGE_SELF, &usage);
+   return static_cast<std::size_t>(usage.ru_maxrss) * 1024;   // ru_maxrss is in kilobytes on Linux
+#endif
+}
+
+// Purpose: Return the physical memory (resident set / working set, in bytes) this process is using now
+std::size_t buf::processResidentBytes()
+{
+#ifdef _WIN32
+   PROCESS_MEMORY_COUNTERS memory_counters{};
+   if (!GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters, sizeof(memory_counters)))
+      return 0;
+   return memory_counters.WorkingSetSize;
+#else
+   // statm: the total program size, then the resident size (both in pages)
+   std::ifstream statm("/proc/self/statm");
+   std::size_t total_pages = 0;
+   std::size_t resident_pages = 0;
+   if (!(statm >> total_pages >> resident_pages))
+      return 0;
+   return resident_pages * static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+#endif
+}
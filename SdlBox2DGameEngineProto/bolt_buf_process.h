@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+
+// buf: Namespace for Bolton Utility Functions
+//    Process level measurements (CPU time used etc.) wrapped so callers do not need platform headers.
+namespace buf
+{
+   // Return the CPU time (user + system, in seconds) used by this process so far.  
+   //    Note: Compare two readings against the wall-clock time between them to get CPU utilization.
+   double processCpuSeconds();
+
+   // Return the most physical memory (resident set / working set, in bytes) this process has used at once so far
+   std::size_t processPeakResidentBytes();
+   // Return the physical memory (resident set / working set, in bytes) this process is using now
+   //    Note: Compare two readings to see how much memory something took (or gave back), which the peak cannot show once a
+   //          larger peak has been reached.
+   std::size_t processResidentBytes();
+}
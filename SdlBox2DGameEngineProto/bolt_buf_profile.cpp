@@ -0,0 +1,58 @@
+#include "bolt_buf_profile.h"
+
+#include <chrono>
+
+
+// Purpose: Return the ticks per nanosecond
+//    Counts the ticks over a few milliseconds of steady_clock time, once (thread safe, as a function's static is initialized once).
+double buf::CycleClock::ticksPerNanosecond()
+{
+   static const double ticks_per_nanosecond = []()
+   {
+      using Clock = std::chrono::steady_clock;
+      constexpr std::chrono::milliseconds calibration_time{ 5 };
+
+      const auto start_time = Clock::now();
+      const std::uint64_t start_ticks = now();
+      auto end_time = start_time;
+      while (end_time - start_time < calibration_time)
+         end_time = Clock::now();
+      const std::uint64_t end_ticks = now();
+
+      const double nanoseconds = std::chrono::duration<double, std::nano>(end_time - start_time).count();
+      return (end_ticks > start_ticks) ? (end_ticks - start_ticks) / nanoseconds : 1.0;
+   }();
+
+   return ticks_per_nanosecond;
+}
+
+// Purpose: Return the value that the fraction (0 to 1) of the values are at or below
+//    Walks the buckets until the count so far reaches the fraction of the total.
+std::uint64_t buf::Histogram::percentile(double fraction) const
+{
+   if (total_count == 0)
+      return 0;
+
+   const double clamped_fraction = std::clamp(fraction, 0.0, 1.0);
+   const std::uint64_t target = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(clamped_fraction * total_count + 0.5));
+
+   std::uint64_t count_so_far = 0;
+   for (std::size_t bucket = 0; bucket < BucketCount; ++bucket)
+   {
+      count_so_far += counts[bucket];
+      if (count_so_far >= target)
+         return std::min(bucketTop(bucket), max_value);
+   }
+   return max_value;
+}
+
+// Purpose: Return the largest value counted by the bucket
+std::uint64_t buf::Histogram::bucketTop(std::size_t bucket)
+{
+   if (bucket < 2 * SubBucketCount)
+      return bucket;   // Exact
+
+   const int shift = static_cast<int>(bucket / SubBucketCount) - 1;
+   const std::uint64_t sub_bucket = bucket - static_cast<std::size_t>(shift) * SubBucketCount;   // SubBucketCount to 2 * SubBucketCount - 1
+   return ((sub_bucket + 1) << shift) - 1;   // Wraps to the largest 64-bit value for the very last bucket
+}
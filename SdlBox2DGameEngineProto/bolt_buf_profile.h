@@ -0,0 +1,141 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define BUF_HAS_RDTSC
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BUF_HAS_RDTSC
+#else
+#include <chrono>
+#endif
+
+// buf: Namespace for Bolton Utility Functions
+//    Lightweight profiling: a cheap tick clock, fixed size HDR-style histograms, and scoped timers that record how long a scope
+//    took in a histogram.  A timed scope (BUF_PROFILE_SCOPE) costs a few nanoseconds: two reads of the CPU's time stamp counter
+//    and a histogram increment.  Building with BOLT_DISABLE_PROFILING defined removes the timed scopes completely.
+namespace buf
+{
+#ifdef BOLT_DISABLE_PROFILING
+   constexpr bool ProfilingEnabled = false;
+#else
+   constexpr bool ProfilingEnabled = true;
+#endif
+
+   // A very cheap clock for timing short scopes: the CPU's time stamp counter (or steady_clock nanoseconds on other targets)
+   class CycleClock
+   {
+   public:
+      // Return the current tick count
+      static std::uint64_t now()
+      {
+#ifdef BUF_HAS_RDTSC
+         return __rdtsc();
+#else
+         return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+      }
+
+      // Return the ticks per nanosecond (measured against std::chrono::steady_clock the first time it is called, which takes
+      // a few milliseconds)
+      static double ticksPerNanosecond();
+      // Convert ticks to microseconds
+      static double toMicroseconds(std::uint64_t ticks) { return static_cast<double>(ticks) / (ticksPerNanosecond() * 1000.0); };
+   };
+
+   // Counts of values (e.g. ticks) in HDR-style log-linear buckets: exact below 64, then 32 buckets for each power of two (so a
+   // value is known to within about 3%).  The buckets cover every 64-bit value and are allocated with the histogram, so
+   // recording a value is an increment and never allocates.
+   class Histogram
+   {
+   public:
+      static constexpr int SubBucketBits = 5;
+      static constexpr std::size_t SubBucketCount = std::size_t{ 1 } << SubBucketBits;   // Buckets per power of two
+      static constexpr int MaxShift = 64 - (SubBucketBits + 1);                           // Shift of the largest values
+      static constexpr std::size_t BucketCount = (MaxShift + 2) * SubBucketCount;
+
+      // Count a value
+      void record(std::uint64_t value)
+      {
+         ++counts[bucketOf(value)];
+         ++total_count;
+         total += value;
+         max_value = std::max(max_value, value);
+      }
+
+      // Number of values counted
+      std::uint64_t count() const { return total_count; };
+      // Largest value counted (zero if none)
+      std::uint64_t maxValue() const { return max_value; };
+      // Average of the values counted (zero if none)
+      double mean() const { return (total_count > 0) ? static_cast<double>(total) / total_count : 0.0; };
+      // Return the value that the fraction (0 to 1) of the values are at or below: the top of the value's bucket (at most
+      // maxValue()), so it may be up to about 3% high.  Zero if nothing was counted.
+      std::uint64_t percentile(double fraction) const;
+      // Forget every value
+      void reset() { counts.fill(0); total_count = 0; total = 0; max_value = 0; };
+
+      // Return the bucket that counts the value
+      static std::size_t bucketOf(std::uint64_t value)
+      {
+         const int shift = std::max(0, static_cast<int>(std::bit_width(value)) - (SubBucketBits + 1));
+         return static_cast<std::size_t>(shift) * SubBucketCount + static_cast<std::size_t>(value >> shift);
+      }
+      // Return the largest value counted by the bucket
+      static std::uint64_t bucketTop(std::size_t bucket);
+
+   private:
+      std::array<std::uint32_t, BucketCount> counts{};
+      std::uint64_t total_count = 0;
+      std::uint64_t total = 0;
+      std::uint64_t max_value = 0;
+   };
+
+   // Records the ticks from its construction to its destruction in a histogram (see BUF_PROFILE_SCOPE)
+   class ScopedTimer
+   {
+   public:
+      explicit ScopedTimer(Histogram& _histogram) : histogram(_histogram), start(CycleClock::now()) {};
+      ~ScopedTimer() { histogram.record(CycleClock::now() - start); };
+      ScopedTimer(const ScopedTimer&) = delete;
+      ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+   private:
+      Histogram& histogram;
+      std::uint64_t start;
+   };
+
+   // Adds the ticks from its construction to its destruction to a total (see BUF_PROFILE_ACCUMULATE), for a scope run many times
+   // whose total time matters (e.g. a callback)
+   class ScopedTickCounter
+   {
+   public:
+      explicit ScopedTickCounter(std::uint64_t& _total_ticks) : total_ticks(_total_ticks), start(CycleClock::now()) {};
+      ~ScopedTickCounter() { total_ticks += CycleClock::now() - start; };
+      ScopedTickCounter(const ScopedTickCounter&) = delete;
+      ScopedTickCounter& operator=(const ScopedTickCounter&) = delete;
+
+   private:
+      std::uint64_t& total_ticks;
+      std::uint64_t start;
+   };
+}
+
+//// Timed scopes: time the rest of the enclosing scope.  With BOLT_DISABLE_PROFILING defined they (and their argument) are removed.
+//    BUF_PROFILE_SCOPE(histogram):       Record the scope's ticks in the buf::Histogram
+//    BUF_PROFILE_ACCUMULATE(total):      Add the scope's ticks to the std::uint64_t total
+#define BUF_PROFILE_CONCAT_INNER(a, b) a##b
+#define BUF_PROFILE_CONCAT(a, b) BUF_PROFILE_CONCAT_INNER(a, b)
+#ifdef BOLT_DISABLE_PROFILING
+#define BUF_PROFILE_SCOPE(histogram) ((void)0)
+#define BUF_PROFILE_ACCUMULATE(total) ((void)0)
+#else
+#define BUF_PROFILE_SCOPE(histogram) const buf::ScopedTimer BUF_PROFILE_CONCAT(buf_profile_scope_, __LINE__){ histogram }
+#define BUF_PROFILE_ACCUMULATE(total) const buf::ScopedTickCounter BUF_PROFILE_CONCAT(buf_profile_scope_, __LINE__){ total }
+#endif
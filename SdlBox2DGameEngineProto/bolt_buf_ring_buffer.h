@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <vector>
+
+// buf: Namespace for Bolton Utility Functions
+namespace buf
+{
+   //// SpscRingBuffer ////
+   // A fixed capacity, lock-free queue for one producer thread and one consumer thread (which may be the same thread).
+   // All memory is allocated by the constructor, so pushing and popping never allocate.  Pushing to a full buffer fails
+   // (rather than blocking), so the producer can count what was dropped and carry on.
+   //    Usage:
+   //       buf::SpscRingBuffer<Event> events{ 1024 };
+   //       if (!events.tryPush(event)) ++dropped;           // Producer
+   //       events.drain([](const Event& event) { ... });    // Consumer
+   //
+   template <typename T>
+   class SpscRingBuffer
+   {
+   public:
+      // Capacity is rounded up to a power of two
+      explicit SpscRingBuffer(std::size_t min_capacity) : slots(std::bit_ceil(min_capacity < 2 ? 2 : min_capacity)), index_mask(slots.size() - 1) {};
+
+      SpscRingBuffer(const SpscRingBuffer&) = delete;
+      SpscRingBuffer& operator=(const SpscRingBuffer&) = delete;
+
+      // Producer: Add an item to the back.  Returns false (and drops the item) if the buffer is full.
+      bool tryPush(const T& item)
+      {
+         const std::size_t tail = tail_index.load(std::memory_order_relaxed);
+         if (tail - head_index.load(std::memory_order_acquire) == slots.size())
+            return false;
+
+         slots[tail & index_mask] = item;
+         tail_index.store(tail + 1, std::memory_order_release);
+         return true;
+      }
+
+      // Consumer: Remove the item at the front.  Returns false if the buffer is empty.
+      bool tryPop(T& item)
+      {
+         const std::size_t head = head_index.load(std::memory_order_relaxed);
+         if (head == tail_index.load(std::memory_order_acquire))
+            return false;
+
+         item = slots[head & index_mask];
+         head_index.store(head + 1, std::memory_order_release);
+         return true;
+      }
+
+      // Consumer: Call func(const T&) on every item in the buffer (oldest first) and remove them.  Returns the number of items.
+      template <typename Func>
+      std::size_t drain(Func&& func)
+      {
+         const std::size_t head = head_index.load(std::memory_order_relaxed);
+         const std::size_t tail = tail_index.load(std::memory_order_acquire);
+
+         for (std::size_t index = head; index != tail; ++index)
+            func(static_cast<const T&>(slots[index & index_mask]));
+
+         head_index.store(tail, std::memory_order_release);
+         return tail - head;
+      }
+
+      // Number of items in the buffer (exact when called from the producer or consumer thread while the other is idle)
+      std::size_t size() const { return tail_index.load(std::memory_order_acquire) - head_index.load(std::memory_order_acquire); };
+      std::size_t capacity() const { return slots.size(); };
+
+   private:
+      std::vector<T> slots;
+      const std::size_t index_mask;   // Indexes only ever increase; "index & index_mask" is the slot
+
+      // Kept on separate cache lines, so the producer and consumer threads do not fight over one line
+      alignas(64) std::atomic<std::size_t> head_index{ 0 };   // Next item to pop (only the consumer writes it)
+      alignas(64) std::atomic<std::size_t> tail_index{ 0 };   // Next slot to push to (only the producer writes it)
+   };
+}
@@ -0,0 +1,247 @@
+#include "bolt_buf_trace.h"
+#include "bolt_buf_profile.h"
+#include "bolt_buf_ring_buffer.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <format>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+
+namespace
+{
+   using namespace std::string_literals;
+
+   constexpr std::chrono::milliseconds FlushInterval{ 20 };   // How often the background thread drains the buffers
+
+   struct TraceEvent
+   {
+      const char* name;
+      std::uint64_t ticks;   // buf::CycleClock
+      char phase;            // 'B' (begin) or 'E' (end)
+   };
+
+   // One thread's events.  Only that thread pushes (and touches open_spans and session), only the flush thread drains.
+   struct ThreadBuffer
+   {
+      explicit ThreadBuffer(std::uint32_t _thread_id) : events(buf::TraceRecorder::EventsPerThread), thread_id(_thread_id) {};
+
+      buf::SpscRingBuffer<TraceEvent> events;
+      const std::uint32_t thread_id;
+      std::uint32_t open_spans = 0;   // Spans begun and not yet ended (each has a slot kept for its end)
+      std::uint64_t session = 0;      // The recording session open_spans belongs to
+   };
+
+   struct TraceState
+   {
+      std::mutex mutex;                                          // Guards thread_buffers and stop_requested
+      std::condition_variable stop_condition;
+      bool stop_requested = false;
+      // Never freed: a thread keeps a pointer to its buffer for as long as it runs (and may be recording as recording stops)
+      std::vector<std::unique_ptr<ThreadBuffer>> thread_buffers;
+
+      std::atomic<std::uint64_t> session{ 0 };                   // Counts the times recording started
+      std::atomic<std::uint64_t> dropped_count{ 0 };
+      std::atomic<std::uint64_t> written_count{ 0 };
+
+      // Only used by the flush thread while recording (and by start() and stop() while it is not running)
+      std::ofstream file;
+      std::thread flush_thread;
+      std::uint64_t start_ticks = 0;
+      double ticks_per_microsecond = 1.0;
+      bool first_event = true;
+   };
+
+   TraceState& traceState()
+   {
+      static TraceState state;
+      return state;
+   }
+
+   thread_local ThreadBuffer* thread_buffer = nullptr;   // This thread's buffer (null until it first records)
+   thread_local bool thread_untraced = false;            // This thread came after MaxThreads, so is not traced
+
+   // Purpose: Return this thread's buffer, adding one the first time the thread records (null if there are too many threads)
+   ThreadBuffer* threadBuffer(TraceState& state)
+   {
+      if (thread_buffer == nullptr && !thread_untraced)
+      {
+         std::lock_guard lock(state.mutex);
+         if (state.thread_buffers.size() < buf::TraceRecorder::MaxThreads)
+         {
+            state.thread_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<std::uint32_t>(state.thread_buffers.size() + 1)));
+            thread_buffer = state.thread_buffers.back().get();
+         }
+         else
+            thread_untraced = true;
+      }
+      return thread_buffer;
+   }
+
+   // Purpose: Write the events in every buffer to the file
+   void writeEvents(TraceState& state, std::span<ThreadBuffer* const> buffers, std::string& text)
+   {
+      for (ThreadBuffer* buffer : buffers)
+      {
+         text.clear();
+         const std::size_t event_count = buffer->events.drain([&](const TraceEvent& event)
+         {
+            const double microseconds = static_cast<double>(event.ticks - state.start_ticks) / state.ticks_per_microsecond;
+            std::format_to(std::back_inserter(text), "{}{{\"name\":\"{}\",\"ph\":\"{}\",\"ts\":{:.3f},\"pid\":1,\"tid\":{}}}",
+               state.first_event ? "\n" : ",\n", event.name, event.phase, microseconds, buffer->thread_id);
+            state.first_event = false;
+         });
+
+         state.file.write(text.data(), static_cast<std::streamsize>(text.size()));
+         state.written_count.fetch_add(event_count, std::memory_order_relaxed);
+      }
+   }
+
+   // Purpose: The flush thread: drain the buffers to the file every FlushInterval, until stop() asks it to finish
+   void flushLoop()
+   {
+      TraceState& state = traceState();
+      std::vector<ThreadBuffer*> buffers;
+      std::string text;
+
+      bool stopping = false;
+      while (!stopping)
+      {
+         {
+            std::unique_lock lock(state.mutex);
+            state.stop_condition.wait_for(lock, FlushInterval, [&state]() { return state.stop_requested; });
+            stopping = state.stop_requested;
+
+            buffers.clear();
+            for (const auto& buffer : state.thread_buffers)
+               buffers.push_back(buffer.get());
+         }
+
+         writeEvents(state, buffers, text);   // Without the lock, so new threads are not held up by the disk
+      }
+   }
+}
+
+
+// Purpose: Start recording to a trace file (replacing it)
+//    The first time, stop() is registered to run at exit: if the process exits while recording (e.g. exit() from a library), 
+//    the file is still finished, and the flush thread joined before the state it belongs to is destroyed (destroying a joinable
+//    std::thread calls std::terminate()).  Registered after the state is made, so it runs before the state is destroyed.
+buf::Result<void> buf::TraceRecorder::start(const std::string& path)
+{
+   TraceState& state = traceState();
+   if (recording.load(std::memory_order_acquire))
+      return buf::unexpected("Already recording a trace."s);
+
+   static const bool stop_registered = (std::atexit([]() { TraceRecorder::stop(); }) == 0);
+   if (!stop_registered)
+      return buf::unexpected("Could not register the trace recorder to stop at exit."s);
+
+   state.file.open(path, std::ios::trunc);
+   if (!state.file)
+   {
+      state.file.clear();
+      return buf::unexpected(std::format("Could not open the trace file: {}", path));
+   }
+   state.file << "{\"traceEvents\":[";
+
+   {
+      std::lock_guard lock(state.mutex);
+      for (const auto& buffer : state.thread_buffers)
+         buffer->events.drain([](const TraceEvent&) {});   // Anything recorded as the last recording stopped
+      state.stop_requested = false;
+   }
+
+   state.session.fetch_add(1, std::memory_order_acq_rel);   // Spans left open by the last recording are forgotten
+   state.dropped_count.store(0, std::memory_order_relaxed);
+   state.written_count.store(0, std::memory_order_relaxed);
+   state.ticks_per_microsecond = CycleClock::ticksPerNanosecond() * 1000.0;
+   state.start_ticks = CycleClock::now();
+   state.first_event = true;
+
+   state.flush_thread = std::thread(flushLoop);
+   recording.store(true, std::memory_order_release);
+   return Result<void>{};
+}
+
+// Purpose: Stop recording: write the events still buffered and finish the file
+void buf::TraceRecorder::stop()
+{
+   TraceState& state = traceState();
+   if (!recording.exchange(false, std::memory_order_acq_rel))
+      return;
+
+   {
+      std::lock_guard lock(state.mutex);
+      state.stop_requested = true;
+   }
+   state.stop_condition.notify_one();
+   state.flush_thread.join();   // Drains the buffers once more before it returns
+
+   state.file << std::format("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{{\"dropped_events\":{}}}}}\n", droppedCount());
+   state.file.close();
+}
+
+// Purpose: Number of events dropped (because a buffer was full) since recording started
+std::uint64_t buf::TraceRecorder::droppedCount()
+{
+   return traceState().dropped_count.load(std::memory_order_relaxed);
+}
+
+// Purpose: Number of events written to the file since recording started
+std::uint64_t buf::TraceRecorder::writtenCount()
+{
+   return traceState().written_count.load(std::memory_order_relaxed);
+}
+
+// Purpose: Record the start of a span on this thread
+//    The span is only begun if the buffer has room for its end and the ends of every span still open on the thread, so an end
+//    is never dropped (the flush thread only ever makes more room).
+bool buf::TraceRecorder::begin(const char* name)
+{
+   TraceState& state = traceState();
+   if (!recording.load(std::memory_order_relaxed))
+      return false;
+
+   ThreadBuffer* buffer = threadBuffer(state);
+   if (buffer == nullptr)
+   {
+      state.dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   const std::uint64_t session = state.session.load(std::memory_order_acquire);
+   if (buffer->session != session)
+   {
+      buffer->session = session;
+      buffer->open_spans = 0;
+   }
+
+   const std::size_t free_slots = buffer->events.capacity() - buffer->events.size();
+   if (free_slots < buffer->open_spans + 2u)
+   {
+      state.dropped_count.fetch_add(1, std::memory_order_relaxed);
+      return false;
+   }
+
+   buffer->events.tryPush({ name, CycleClock::now(), 'B' });
+   ++buffer->open_spans;
+   return true;
+}
+
+// Purpose: Record the end of the span most recently begun (and not dropped) on this thread
+void buf::TraceRecorder::end(const char* name)
+{
+   ThreadBuffer* buffer = thread_buffer;
+   if (buffer == nullptr || buffer->open_spans == 0 || buffer->session != traceState().session.load(std::memory_order_acquire))
+      return;   // Begun in an earlier recording
+
+   buffer->events.tryPush({ name, CycleClock::now(), 'E' });
+   --buffer->open_spans;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "bolt_buf_result.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// buf: Namespace for Bolton Utility Functions
+//    Records a timeline of named spans (begin and end events) from any thread to a Chrome trace-event JSON file, which can be
+//    opened in a trace viewer (chrome://tracing or https://ui.perfetto.dev).
+//    - Each thread records to its own lock-free buffer (a SpscRingBuffer), and a background thread drains the buffers to the
+//      file, so recording a span never waits on a lock or the disk.
+//    - The memory is capped: each thread's buffer has a fixed size, and only the first MaxThreads threads are traced.  When a
+//      buffer is full, new spans are dropped (and counted) rather than waiting.  A span is only begun when there is room for its
+//      end, so the spans in the file always match up.
+//    - Building with BOLT_DISABLE_PROFILING defined removes the traced scopes (BUF_TRACE_SCOPE) completely.
+//    Usage:
+//       buf::TraceRecorder::start("trace.json");
+//       { BUF_TRACE_SCOPE("step"); ... }
+//       buf::TraceRecorder::stop();
+namespace buf
+{
+   class TraceRecorder
+   {
+   public:
+      static constexpr std::size_t EventsPerThread = 32768;   // Size of each thread's buffer (24 bytes an event)
+      static constexpr std::size_t MaxThreads = 64;           // Threads after this many are not traced
+
+      // Start recording to a trace file (replacing it).  Returns an error if already recording, or the file cannot be opened.
+      static Result<void> start(const std::string& path);
+      // Stop recording: write the events still buffered and finish the file.  Does nothing if not recording.  Also runs at exit
+      // (if still recording then), so the file is finished however the process ends normally.
+      static void stop();
+      // Return true if recording
+      static bool isRecording() { return recording.load(std::memory_order_relaxed); };
+      // Number of events dropped (because a buffer was full) since recording started
+      static std::uint64_t droppedCount();
+      // Number of events written to the file since recording started
+      static std::uint64_t writtenCount();
+
+      // Record the start of a span on this thread.  The name must stay valid until recording stops (e.g. a string literal),
+      // and must not need escaping in JSON.  Returns false if the span was not begun (not recording, or dropped).
+      static bool begin(const char* name);
+      // Record the end of the span most recently begun (and not dropped) on this thread
+      static void end(const char* name);
+
+   private:
+      inline static std::atomic<bool> recording{ false };
+   };
+
+   // Records a span from its construction to its destruction (see BUF_TRACE_SCOPE)
+   class ScopedTraceEvent
+   {
+   public:
+      explicit ScopedTraceEvent(const char* _name) : name(_name), begun(TraceRecorder::isRecording() && TraceRecorder::begin(_name)) {};
+      ~ScopedTraceEvent() { if (begun) TraceRecorder::end(name); };
+      ScopedTraceEvent(const ScopedTraceEvent&) = delete;
+      ScopedTraceEvent& operator=(const ScopedTraceEvent&) = delete;
+
+   private:
+      const char* name;
+      bool begun;
+   };
+}
+
+//// Traced scopes: record the rest of the enclosing scope as a span named by a string literal (when recording).  With
+//   BOLT_DISABLE_PROFILING defined they are removed.
+#ifdef BOLT_DISABLE_PROFILING
+#define BUF_TRACE_SCOPE(name) ((void)0)
+#else
+#define BUF_TRACE_SCOPE(name) const buf::ScopedTraceEvent BUF_TRACE_CONCAT(buf_trace_scope_, __LINE__){ name }
+#endif
+#define BUF_TRACE_CONCAT_INNER(a, b) a##b
+#define BUF_TRACE_CONCAT(a, b) BUF_TRACE_CONCAT_INNER(a, b)
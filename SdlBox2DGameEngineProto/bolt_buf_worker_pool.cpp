@@ -0,0 +1,84 @@
+#include "bolt_buf_worker_pool.h"
+
+// Purpose: Start the worker threads (the caller is the last of the thread_count threads)
+buf::WorkerPool::WorkerPool(std::size_t thread_count)
+{
+   const std::size_t worker_count = (thread_count > 1) ? thread_count - 1 : 0;
+   threads.reserve(worker_count);
+   for (std::size_t worker = 0; worker < worker_count; ++worker)
+      threads.emplace_back([this]() { workerLoop(); });
+}
+
+// Purpose: Stop and join the worker threads
+buf::WorkerPool::~WorkerPool()
+{
+   {
+      std::lock_guard lock(mutex);
+      stopping = true;
+   }
+   loop_ready.notify_all();
+
+   for (std::thread& thread : threads)
+      thread.join();
+}
+
+// Purpose: Call func(index) for every index in [0, count), spread over the threads.  Returns when every call has returned.
+void buf::WorkerPool::parallelFor(std::size_t count, const std::function<void(std::size_t)>& func)
+{
+   if (threads.empty() || count <= 1)
+   {
+      for (std::size_t index = 0; index < count; ++index)
+         func(index);
+      return;
+   }
+
+   {
+      std::lock_guard lock(mutex);
+      loop_func = &func;
+      loop_count = count;
+      next_index.store(0, std::memory_order_relaxed);
+      busy_workers = threads.size();
+      ++loop_generation;
+   }
+   loop_ready.notify_all();
+
+   runIterations();   // The caller works too, rather than just waiting
+
+   std::unique_lock lock(mutex);
+   loop_done.wait(lock, [this]() { return busy_workers == 0; });
+   loop_func = nullptr;
+}
+
+// Purpose: Wait for loops to run, and run their iterations, until the pool is destroyed
+void buf::WorkerPool::workerLoop()
+{
+   std::uint64_t seen_generation = 0;
+   for (;;)
+   {
+      {
+         std::unique_lock lock(mutex);
+         loop_ready.wait(lock, [&]() { return stopping || loop_generation != seen_generation; });
+         if (stopping)
+            return;
+         seen_generation = loop_generation;
+      }
+
+      runIterations();
+
+      bool last_worker = false;
+      {
+         std::lock_guard lock(mutex);
+         last_worker = (--busy_workers == 0);
+      }
+      if (last_worker)
+         loop_done.notify_one();
+   }
+}
+
+// Purpose: Run iterations of the current loop until there are none left
+//    Note: loop_func and loop_count are only written (under the mutex) while no thread is running iterations
+void buf::WorkerPool::runIterations()
+{
+   for (std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed); index < loop_count; index = next_index.fetch_add(1, std::memory_order_relaxed))
+      (*loop_func)(index);
+}
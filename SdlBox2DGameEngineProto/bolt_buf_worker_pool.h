@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// buf: Namespace for Bolton Utility Functions
+namespace buf
+{
+   //// WorkerPool ////
+   // A fixed set of threads (started once) that run the iterations of a parallel loop.  The calling thread runs iterations
+   // too, so a pool of thread_count threads starts thread_count - 1 workers, and a pool of one thread runs everything on the
+   // caller.  Iterations are handed out one at a time as threads become free, so uneven iterations balance themselves.
+   //    Usage:
+   //       buf::WorkerPool pool{ std::thread::hardware_concurrency() };
+   //       pool.parallelFor(worlds.size(), [&](std::size_t index) { worlds[index].step(); });
+   //
+   class WorkerPool
+   {
+   public:
+      explicit WorkerPool(std::size_t thread_count);
+      ~WorkerPool();
+
+      WorkerPool(const WorkerPool&) = delete;
+      WorkerPool& operator=(const WorkerPool&) = delete;
+
+      // Number of threads that run iterations (the workers and the caller)
+      std::size_t threadCount() const { return threads.size() + 1; };
+
+      // Call func(index) for every index in [0, count), spread over the threads.  Returns when every call has returned.
+      //    Note: func must not throw, and must not call parallelFor() on the same pool.  Only one thread may call parallelFor() at a time.
+      void parallelFor(std::size_t count, const std::function<void(std::size_t)>& func);
+
+   private:
+      // Wait for loops to run, and run their iterations, until the pool is destroyed
+      void workerLoop();
+      // Run iterations of the current loop until there are none left
+      void runIterations();
+
+      std::vector<std::thread> threads;
+      std::mutex mutex;
+      std::condition_variable loop_ready;                      // A new loop started (or the pool is stopping)
+      std::condition_variable loop_done;                       // A worker finished its part of the loop
+      const std::function<void(std::size_t)>* loop_func{ nullptr };
+      std::size_t loop_count{ 0 };
+      std::atomic<std::size_t> next_index{ 0 };                // Next iteration to hand out
+      std::size_t busy_workers{ 0 };                           // Workers still running iterations of the current loop
+      std::uint64_t loop_generation{ 0 };                      // Incremented for each loop, so workers see each loop once
+      bool stopping{ false };
+   };
+}